@@ -87,6 +87,8 @@ echo "Configuring FFmpeg with position-independent code (PIC) enabled"
   --enable-decoder=mp3float \
   --enable-muxer=mp3 \
   --enable-muxer=mp4 \
+  --enable-muxer=ipod \
+  --enable-muxer=adts \
   --enable-muxer=ogg \
   --enable-muxer=wav \
   --enable-muxer=flac \
@@ -104,6 +106,7 @@ echo "Configuring FFmpeg with position-independent code (PIC) enabled"
   --enable-parser=amr \
   --enable-bsf=h264_mp4toannexb \
   --enable-bsf=hevc_mp4toannexb \
+  --enable-bsf=aac_adtstoasc \
   --disable-x86asm \
   --disable-inline-asm \
   --pkg-config-flags=--static \
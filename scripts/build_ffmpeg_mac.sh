@@ -80,6 +80,8 @@ export PKG_CONFIG_PATH="$PREFIX/lib/pkgconfig:/opt/homebrew/lib/pkgconfig:/usr/l
   --enable-decoder=mp3float \
   --enable-muxer=mp3 \
   --enable-muxer=mp4 \
+  --enable-muxer=ipod \
+  --enable-muxer=adts \
   --enable-muxer=ogg \
   --enable-muxer=wav \
   --enable-muxer=flac \
@@ -97,6 +99,7 @@ export PKG_CONFIG_PATH="$PREFIX/lib/pkgconfig:/opt/homebrew/lib/pkgconfig:/usr/l
   --enable-parser=amr \
   --enable-bsf=h264_mp4toannexb \
   --enable-bsf=hevc_mp4toannexb \
+  --enable-bsf=aac_adtstoasc \
   --pkg-config-flags=--static \
   --extra-cflags="$EXTRA_CFLAGS" \
   --extra-cxxflags="$EXTRA_CXXFLAGS" \
@@ -128,6 +128,8 @@ CONFIGURE_FLAGS=(
   --enable-decoder=mp3float \
   --enable-muxer=mp3 \
   --enable-muxer=mp4 \
+  --enable-muxer=ipod \
+  --enable-muxer=adts \
   --enable-muxer=ogg \
   --enable-muxer=wav \
   --enable-muxer=flac \
@@ -145,6 +147,7 @@ CONFIGURE_FLAGS=(
   --enable-parser=amr \
   --enable-bsf=h264_mp4toannexb \
   --enable-bsf=hevc_mp4toannexb \
+  --enable-bsf=aac_adtstoasc \
   --pkg-config-flags=--static
 )
 
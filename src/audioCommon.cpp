@@ -0,0 +1,207 @@
+#include "audioCommon.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+extern "C"
+{
+#include <libavutil/opt.h>
+}
+
+enum AVSampleFormat ParsePcmSampleFormat(const std::string &name, bool planar)
+{
+    enum AVSampleFormat fmt = AV_SAMPLE_FMT_NONE;
+    if (name == "s16")
+        fmt = AV_SAMPLE_FMT_S16;
+    else if (name == "s32")
+        fmt = AV_SAMPLE_FMT_S32;
+    else if (name == "f32" || name == "flt")
+        fmt = AV_SAMPLE_FMT_FLT;
+
+    if (fmt != AV_SAMPLE_FMT_NONE && planar)
+        fmt = av_get_planar_sample_fmt(fmt);
+    return fmt;
+}
+
+const char *PcmSampleFormatName(enum AVSampleFormat fmt)
+{
+    switch (av_get_packed_sample_fmt(fmt))
+    {
+    case AV_SAMPLE_FMT_S16:
+        return "s16";
+    case AV_SAMPLE_FMT_S32:
+        return "s32";
+    case AV_SAMPLE_FMT_FLT:
+        return "f32";
+    default:
+        return "";
+    }
+}
+
+Value NewPcmTypedArray(Napi::Env env, std::vector<uint8_t> &&data, enum AVSampleFormat fmt)
+{
+    int bytesPerSample = av_get_bytes_per_sample(fmt);
+    size_t length = bytesPerSample > 0 ? data.size() / bytesPerSample : 0;
+
+    // 拷贝到 V8 自己分配的 ArrayBuffer:Electron 等启用 V8 sandbox 的运行时
+    // 不接受指向外部内存的 ArrayBuffer (napi_no_external_buffers_allowed)
+    ArrayBuffer ab = ArrayBuffer::New(env, data.size());
+    if (!data.empty())
+        memcpy(ab.Data(), data.data(), data.size());
+    std::vector<uint8_t>().swap(data);
+
+    switch (av_get_packed_sample_fmt(fmt))
+    {
+    case AV_SAMPLE_FMT_S32:
+        return TypedArrayOf<int32_t>::New(env, length, ab, 0);
+    case AV_SAMPLE_FMT_FLT:
+        return TypedArrayOf<float>::New(env, length, ab, 0);
+    default:
+        return TypedArrayOf<int16_t>::New(env, length, ab, 0);
+    }
+}
+
+bool IsSilkApiSampleRate(int rate)
+{
+    static const int silk_rates[] = {48000, 44100, 32000, 24000, 16000, 12000, 8000};
+    for (int r : silk_rates)
+    {
+        if (r == rate)
+            return true;
+    }
+    return false;
+}
+
+int SilkPacketForMuxer(const AVPacket *in, AVPacket *out)
+{
+    int payload = in->size > 1 ? in->size : 0; // 1 字节标记包还原为长度 0
+    int ret = av_new_packet(out, payload + 2);
+    if (ret < 0)
+        return ret;
+    int16_t n_bytes = (int16_t)payload;
+    memcpy(out->data, &n_bytes, sizeof(n_bytes));
+    if (payload > 0)
+        memcpy(out->data + 2, in->data, payload);
+    return av_packet_copy_props(out, in);
+}
+
+int SilkInternalSampleRate(int bitrate)
+{
+    if (bitrate >= 25000)
+        return 24000;
+    if (bitrate >= 14000)
+        return 16000;
+    if (bitrate >= 10000)
+        return 12000;
+    return 8000;
+}
+
+bool ParseResampleQuality(const std::string &name, ResampleQuality &quality)
+{
+    if (name == "fast")
+        quality = ResampleQuality::Fast;
+    else if (name == "default")
+        quality = ResampleQuality::Default;
+    else if (name == "high")
+        quality = ResampleQuality::High;
+    else
+        return false;
+    return true;
+}
+
+void ApplyResampleQuality(SwrContext *swr, ResampleQuality quality)
+{
+    switch (quality)
+    {
+    case ResampleQuality::Fast:
+        av_opt_set_int(swr, "filter_size", 8, 0);
+        av_opt_set_int(swr, "phase_shift", 6, 0);
+        av_opt_set_int(swr, "linear_interp", 1, 0);
+        av_opt_set_double(swr, "cutoff", 0.9, 0);
+        av_opt_set_int(swr, "dither_method", SWR_DITHER_NONE, 0);
+        break;
+    case ResampleQuality::High:
+        av_opt_set_int(swr, "filter_size", 128, 0);
+        av_opt_set_int(swr, "phase_shift", 14, 0);
+        av_opt_set_int(swr, "linear_interp", 0, 0);
+        av_opt_set_int(swr, "exact_rational", 1, 0);
+        av_opt_set_double(swr, "cutoff", 0.97, 0);
+        av_opt_set_int(swr, "dither_method", SWR_DITHER_TRIANGULAR, 0);
+        break;
+    default:
+        break; // 保持 swr 默认参数
+    }
+}
+
+std::string SegmentOutputPath(const std::string &pattern, int index)
+{
+    char buf[4096];
+    if (av_get_frame_filename2(buf, sizeof(buf), pattern.c_str(), index, 0) == 0)
+        return buf;
+
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "_%03d", index);
+    size_t slash = pattern.find_last_of("/\\");
+    size_t dot = pattern.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return pattern + suffix;
+    return pattern.substr(0, dot) + suffix + pattern.substr(dot);
+}
+
+bool TimeWindow::Seek(AVFormatContext *fmt, int streamIndex)
+{
+    AVStream *st = fmt->streams[streamIndex];
+    timeBase_ = st->time_base;
+    origin_ = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+    if (start_ <= 0)
+        return true;
+
+    // max_ts = ts: 只接受目标之前的 seek 点,之后由 Trim 丢弃多解出的采样
+    int64_t ts = origin_ + av_rescale_q((int64_t)(start_ * AV_TIME_BASE), AV_TIME_BASE_Q, timeBase_);
+    if (avformat_seek_file(fmt, streamIndex, INT64_MIN, ts, ts, 0) >= 0)
+        return true;
+    return avformat_seek_file(fmt, streamIndex, INT64_MIN, ts, ts, AVSEEK_FLAG_ANY) >= 0;
+}
+
+bool TimeWindow::Trim(AVFrame *frame)
+{
+    if (frame->nb_samples <= 0 || frame->sample_rate <= 0)
+        return frame->nb_samples > 0;
+
+    AVRational sample_tb = {1, frame->sample_rate};
+    int64_t ts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+    int64_t pos = ts != AV_NOPTS_VALUE ? av_rescale_q(ts - origin_, timeBase_, sample_tb) : std::max<int64_t>(nextSample_, 0);
+    nextSample_ = pos + frame->nb_samples;
+
+    int64_t begin = (int64_t)(start_ * frame->sample_rate + 0.5);
+    int64_t end = duration_ > 0 ? begin + (int64_t)(duration_ * frame->sample_rate + 0.5) : INT64_MAX;
+    if (pos >= end)
+    {
+        done_ = true;
+        return false;
+    }
+    if (pos + frame->nb_samples <= begin)
+        return false;
+
+    // 开头: 数据指针前移;结尾: 只缩短 nb_samples
+    int skip = pos < begin ? (int)(begin - pos) : 0;
+    int keep = (int)std::min<int64_t>(frame->nb_samples - skip, end - pos - skip);
+    if (skip > 0)
+    {
+        int channels = frame->ch_layout.nb_channels > 0 ? frame->ch_layout.nb_channels : 1;
+        bool planar = av_sample_fmt_is_planar((enum AVSampleFormat)frame->format);
+        int planes = planar ? channels : 1;
+        size_t offset = (size_t)skip * av_get_bytes_per_sample((enum AVSampleFormat)frame->format) * (planar ? 1 : channels);
+        for (int p = 0; p < planes; p++)
+        {
+            frame->extended_data[p] += offset;
+            if (frame->extended_data != frame->data && p < AV_NUM_DATA_POINTERS)
+                frame->data[p] += offset;
+        }
+    }
+    frame->nb_samples = keep;
+    if (pos + skip + keep >= end)
+        done_ = true;
+    return keep > 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+
+// 解析 PCM 采样格式名 ("s16" / "s32" / "f32"),planar 为 true 时返回对应的平面格式
+// 无法识别时返回 AV_SAMPLE_FMT_NONE
+enum AVSampleFormat ParsePcmSampleFormat(const std::string &name, bool planar);
+
+// 采样格式对应的短名 ("s16" / "s32" / "f32"),不区分平面与交错
+const char *PcmSampleFormatName(enum AVSampleFormat fmt);
+
+// 把原生 PCM 拷贝进新的 ArrayBuffer,构造 Int16Array / Int32Array / Float32Array
+// 拷贝后立即释放 data,避免 JS 持有期间两份内存并存
+Value NewPcmTypedArray(Napi::Env env, std::vector<uint8_t> &&data, enum AVSampleFormat fmt);
+
+// SILK 解码器可直接输出的采样率 (ntsilk 解码器的 api_sample_rate 选项)
+bool IsSilkApiSampleRate(int rate);
+
+// SILK 解复用器去掉了每包的 2 字节长度前缀 (DTX 空帧变成 1 字节标记包),
+// 而 ntsilk 复用器按编码器输出原样写入;直接复制 SILK 数据包时用它补回前缀
+int SilkPacketForMuxer(const AVPacket *in, AVPacket *out);
+
+// SILK 编码器按目标码率选择的内部采样率 (SDK 中 SKP_Silk_control_audio_bandwidth 的初始档位)
+// maxInternalSampleRate 固定为 24kHz
+int SilkInternalSampleRate(int bitrate);
+
+// swr 重采样质量档位
+// Fast: 短滤波器 + 线性插值,适合 8k AMR / 16k ASR 等对音质要求不高的场景
+// Default: swr 默认参数 (filter_size 32, phase_shift 10)
+// High: 长滤波器、更高截止频率,输出 s16 时加三角抖动
+enum class ResampleQuality
+{
+    Fast,
+    Default,
+    High
+};
+
+// 解析 'fast' / 'default' / 'high',无法识别时返回 false
+bool ParseResampleQuality(const std::string &name, ResampleQuality &quality);
+
+// 在 swr_init 之前把质量档位写入 swr 选项
+void ApplyResampleQuality(SwrContext *swr, ResampleQuality quality);
+
+// 分段输出的第 index 个文件名 (从 0 开始)
+// pattern 含 %d / %03d 等序号占位符时按它格式化,否则在扩展名前插入 _000 形式的序号
+std::string SegmentOutputPath(const std::string &pattern, int index);
+
+// 解码时间窗口: 先 seek 到 start 之前最近的可 seek 点,再按采样精确裁剪解码帧
+// start / duration 单位为秒,相对于流的起始时间;duration <= 0 表示到文件结尾
+class TimeWindow
+{
+public:
+    TimeWindow(double start, double duration) : start_(start), duration_(duration) {}
+
+    bool Active() const { return start_ > 0 || duration_ > 0; }
+    // 把输入 seek 到窗口起点之前;输入不支持 seek 时返回 false,调用方可从头解码并丢弃
+    bool Seek(AVFormatContext *fmt, int streamIndex);
+    // 裁掉帧中窗口之外的采样 (只移动数据指针,不拷贝);返回 false 表示整帧都在窗口之外
+    bool Trim(AVFrame *frame);
+    // 已越过窗口结尾,调用方可以停止读包
+    bool Done() const { return done_; }
+
+private:
+    double start_;
+    double duration_;
+    AVRational timeBase_ = {1, AV_TIME_BASE};
+    int64_t origin_ = 0;     // 流的起始时间 (timeBase_)
+    int64_t nextSample_ = -1; // 没有时间戳时按采样数累计的位置
+    bool done_ = false;
+};
@@ -0,0 +1,532 @@
+#include "audioSession.h"
+#include "audioCommon.h"
+#include "mediaInput.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+// 会话输出参数,0 表示沿用输入的采样率 / 声道数
+struct SessionOptions
+{
+    int sampleRate = 0;
+    int channels = 0;
+    enum AVSampleFormat sampleFormat = AV_SAMPLE_FMT_S16; // 只支持交错格式
+};
+
+// 会话的解码状态,只在工作线程上持锁访问
+// inputRef 持有 Buffer 输入的引用,与本对象一起在主线程上释放
+class AudioDecoder
+{
+public:
+    AudioDecoder(const MediaInput &input, ObjectReference &&inputRef, const SessionOptions &options)
+        : input_(input), inputRef_(std::move(inputRef)), options_(options) {}
+
+    ~AudioDecoder()
+    {
+        CloseStack();
+    }
+
+    std::mutex mutex;
+    int sampleRate = 0;
+    int channels = 0;
+    double duration = 0;
+    int64_t position = 0; // 下一次 read 返回的第一个采样 (输出采样率)
+    bool closed = false;
+
+    enum AVSampleFormat SampleFormat() const { return options_.sampleFormat; }
+
+    // 打开解复用器/解码器/重采样器,失败返回错误信息
+    std::string Open()
+    {
+        std::string error = OpenStack();
+        if (!error.empty())
+            CloseStack();
+        return error;
+    }
+
+    // 读取最多 nb_samples 个采样 (每声道),到结尾时返回的采样数少于请求数
+    void Read(int nb_samples, std::vector<uint8_t> &out, bool &eof)
+    {
+        size_t frame_bytes = (size_t)av_get_bytes_per_sample(options_.sampleFormat) * channels;
+        size_t want = (size_t)nb_samples * frame_bytes;
+        while (pending_.size() < want && !drained_)
+            DecodeMore();
+
+        size_t take = std::min(want, pending_.size());
+        out.assign(pending_.begin(), pending_.begin() + take);
+        pending_.erase(pending_.begin(), pending_.begin() + take);
+        position += take / frame_bytes;
+        eof = drained_ && pending_.empty();
+    }
+
+    // 定位到 seconds: seek 到之前最近的可 seek 点,再解码丢弃到精确的采样
+    // 输入不支持 seek 时重新打开并从头解码
+    std::string Seek(double seconds)
+    {
+        window_.reset(new TimeWindow(seconds, 0));
+        if (!window_->Seek(fmt_, stream_))
+        {
+            CloseStack();
+            std::string error = OpenStack();
+            if (!error.empty())
+            {
+                CloseStack();
+                closed = true;
+                return error;
+            }
+            window_->Seek(fmt_, stream_);
+        }
+        else
+        {
+            avcodec_flush_buffers(dec_);
+            swr_init(swr_); // 重新初始化以丢弃内部缓存的采样
+        }
+        pending_.clear();
+        demuxEof_ = false;
+        decoderEof_ = false;
+        drained_ = false;
+        position = (int64_t)llround(seconds * sampleRate);
+        return "";
+    }
+
+    void Close()
+    {
+        CloseStack();
+        pending_.clear();
+        closed = true;
+    }
+
+private:
+    std::string OpenStack()
+    {
+        if (OpenMediaInput(&fmt_, input_) < 0)
+            return "Failed to open input";
+        if (avformat_find_stream_info(fmt_, nullptr) < 0)
+            return "Failed to find stream info";
+        stream_ = av_find_best_stream(fmt_, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+        if (stream_ < 0)
+            return "No audio stream";
+        for (unsigned i = 0; i < fmt_->nb_streams; i++)
+        {
+            if ((int)i != stream_)
+                fmt_->streams[i]->discard = AVDISCARD_ALL;
+        }
+
+        AVStream *st = fmt_->streams[stream_];
+        const AVCodec *codec = avcodec_find_decoder(st->codecpar->codec_id);
+        if (!codec)
+            return "Decoder not found";
+        dec_ = avcodec_alloc_context3(codec);
+        if (!dec_ || avcodec_parameters_to_context(dec_, st->codecpar) < 0)
+            return "Failed to allocate decoder";
+
+        // SILK 输入: 让解码器直接输出目标采样率
+        AVDictionary *dec_opts = nullptr;
+        if (st->codecpar->codec_id == AV_CODEC_ID_NTSILK_S16LE && IsSilkApiSampleRate(options_.sampleRate))
+            av_dict_set_int(&dec_opts, "api_sample_rate", options_.sampleRate, 0);
+        int ret = avcodec_open2(dec_, codec, &dec_opts);
+        av_dict_free(&dec_opts);
+        if (ret < 0)
+            return "Failed to open decoder";
+
+        AVChannelLayout in_layout;
+        if (dec_->ch_layout.nb_channels > 0)
+            av_channel_layout_copy(&in_layout, &dec_->ch_layout);
+        else
+            av_channel_layout_default(&in_layout, 1);
+
+        sampleRate = options_.sampleRate > 0 ? options_.sampleRate : dec_->sample_rate;
+        channels = options_.channels > 0 ? options_.channels : in_layout.nb_channels;
+        AVChannelLayout out_layout;
+        av_channel_layout_default(&out_layout, channels);
+
+        ret = swr_alloc_set_opts2(&swr_, &out_layout, options_.sampleFormat, sampleRate,
+                                  &in_layout, dec_->sample_fmt, dec_->sample_rate, 0, nullptr);
+        av_channel_layout_uninit(&in_layout);
+        av_channel_layout_uninit(&out_layout);
+        if (ret < 0 || swr_init(swr_) < 0)
+            return "Failed to initialize resampler";
+
+        pkt_ = av_packet_alloc();
+        frame_ = av_frame_alloc();
+        if (!pkt_ || !frame_)
+            return "Failed to allocate packet/frame";
+
+        duration = fmt_->duration != AV_NOPTS_VALUE ? fmt_->duration / (double)AV_TIME_BASE : 0;
+        return "";
+    }
+
+    void CloseStack()
+    {
+        av_frame_free(&frame_);
+        av_packet_free(&pkt_);
+        swr_free(&swr_);
+        avcodec_free_context(&dec_);
+        if (fmt_)
+            CloseMediaInput(&fmt_);
+    }
+
+    // 转换一帧 (frame 为 nullptr 时冲刷重采样器) 并追加到待读缓冲
+    void Append(const AVFrame *frame)
+    {
+        int in_samples = frame ? frame->nb_samples : 0;
+        int out_samples = swr_get_out_samples(swr_, in_samples);
+        if (out_samples <= 0)
+            return;
+        size_t frame_bytes = (size_t)av_get_bytes_per_sample(options_.sampleFormat) * channels;
+        size_t used = pending_.size();
+        pending_.resize(used + (size_t)out_samples * frame_bytes);
+        uint8_t *dst = pending_.data() + used;
+        int converted = swr_convert(swr_, &dst, out_samples, frame ? (const uint8_t **)frame->extended_data : nullptr, in_samples);
+        pending_.resize(used + (size_t)std::max(converted, 0) * frame_bytes);
+    }
+
+    // 解码出至少一帧追加到待读缓冲;输入结束并冲刷完毕后置 drained_
+    void DecodeMore()
+    {
+        while (true)
+        {
+            int ret = avcodec_receive_frame(dec_, frame_);
+            if (ret == 0)
+            {
+                bool keep = !window_ || window_->Trim(frame_);
+                if (keep)
+                    Append(frame_);
+                av_frame_unref(frame_);
+                if (keep)
+                    return;
+                continue;
+            }
+            if (ret != AVERROR(EAGAIN) || decoderEof_)
+            {
+                Append(nullptr);
+                drained_ = true;
+                return;
+            }
+
+            if (demuxEof_ || av_read_frame(fmt_, pkt_) < 0)
+            {
+                demuxEof_ = true;
+                decoderEof_ = true;
+                avcodec_send_packet(dec_, nullptr);
+                continue;
+            }
+            if (pkt_->stream_index == stream_)
+                avcodec_send_packet(dec_, pkt_);
+            av_packet_unref(pkt_);
+        }
+    }
+
+    MediaInput input_;
+    ObjectReference inputRef_;
+    SessionOptions options_;
+
+    AVFormatContext *fmt_ = nullptr;
+    AVCodecContext *dec_ = nullptr;
+    SwrContext *swr_ = nullptr;
+    AVPacket *pkt_ = nullptr;
+    AVFrame *frame_ = nullptr;
+    int stream_ = -1;
+
+    std::vector<uint8_t> pending_;      // 已转换但尚未读走的采样
+    std::unique_ptr<TimeWindow> window_; // 最近一次 seek 的目标,用于丢弃 seek 点到目标之间的采样
+    bool demuxEof_ = false;
+    bool decoderEof_ = false;
+    bool drained_ = false;
+};
+
+// ===== OpenAudio Async Worker =====
+class OpenAudioWorker : public AsyncWorker
+{
+public:
+    OpenAudioWorker(const std::shared_ptr<AudioDecoder> &decoder, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), decoder_(decoder), deferred_(deferred) {}
+
+    void Execute() override
+    {
+        std::lock_guard<std::mutex> lock(decoder_->mutex);
+        std::string error = decoder_->Open();
+        if (!error.empty())
+            SetError(error);
+    }
+
+    void OnOK() override
+    {
+        deferred_.Resolve(AudioSession::NewInstance(Env(), decoder_));
+    }
+
+    void OnError(const Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    std::shared_ptr<AudioDecoder> decoder_;
+    Promise::Deferred deferred_;
+};
+
+// ===== Session Read Async Worker =====
+class SessionReadWorker : public AsyncWorker
+{
+public:
+    SessionReadWorker(const std::shared_ptr<AudioDecoder> &decoder, int samples, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), decoder_(decoder), samples_(samples), deferred_(deferred), position_(0), eof_(false),
+          sampleRate_(0), channels_(0) {}
+
+    void Execute() override
+    {
+        std::lock_guard<std::mutex> lock(decoder_->mutex);
+        if (decoder_->closed)
+        {
+            SetError("Session is closed");
+            return;
+        }
+        decoder_->Read(samples_, data_, eof_);
+        // 在锁内取快照,OnOK 在主线程运行时 seek 可能正在另一个工作线程上重建解码器
+        position_ = decoder_->position;
+        sampleRate_ = decoder_->sampleRate;
+        channels_ = decoder_->channels;
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        int frame_bytes = av_get_bytes_per_sample(decoder_->SampleFormat()) * channels_;
+        Object res = Object::New(env);
+        res.Set("samples", Number::New(env, frame_bytes > 0 ? (double)(data_.size() / frame_bytes) : 0));
+        res.Set("position", Number::New(env, sampleRate_ > 0 ? (double)position_ / sampleRate_ : 0));
+        res.Set("eof", Boolean::New(env, eof_));
+        res.Set("pcm", NewPcmTypedArray(env, std::move(data_), decoder_->SampleFormat()));
+        deferred_.Resolve(res);
+    }
+
+    void OnError(const Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    std::shared_ptr<AudioDecoder> decoder_;
+    int samples_;
+    Promise::Deferred deferred_;
+    std::vector<uint8_t> data_;
+    int64_t position_;
+    bool eof_;
+    int sampleRate_;
+    int channels_;
+};
+
+// ===== Session Seek Async Worker =====
+class SessionSeekWorker : public AsyncWorker
+{
+public:
+    SessionSeekWorker(const std::shared_ptr<AudioDecoder> &decoder, double seconds, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), decoder_(decoder), seconds_(seconds), deferred_(deferred) {}
+
+    void Execute() override
+    {
+        std::lock_guard<std::mutex> lock(decoder_->mutex);
+        if (decoder_->closed)
+        {
+            SetError("Session is closed");
+            return;
+        }
+        std::string error = decoder_->Seek(seconds_);
+        if (!error.empty())
+            SetError(error);
+    }
+
+    void OnOK() override
+    {
+        deferred_.Resolve(Number::New(Env(), seconds_));
+    }
+
+    void OnError(const Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    std::shared_ptr<AudioDecoder> decoder_;
+    double seconds_;
+    Promise::Deferred deferred_;
+};
+
+// ===== Session Close Async Worker =====
+class SessionCloseWorker : public AsyncWorker
+{
+public:
+    SessionCloseWorker(const std::shared_ptr<AudioDecoder> &decoder, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), decoder_(decoder), deferred_(deferred) {}
+
+    void Execute() override
+    {
+        std::lock_guard<std::mutex> lock(decoder_->mutex);
+        decoder_->Close();
+    }
+
+    void OnOK() override
+    {
+        deferred_.Resolve(Env().Undefined());
+    }
+
+    void OnError(const Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    std::shared_ptr<AudioDecoder> decoder_;
+    Promise::Deferred deferred_;
+};
+
+// ===== AudioSession =====
+
+FunctionReference AudioSession::constructor_;
+
+Function AudioSession::Init(Napi::Env env)
+{
+    Function func = DefineClass(env, "AudioSession", {
+        InstanceMethod("read", &AudioSession::Read),
+        InstanceMethod("seek", &AudioSession::Seek),
+        InstanceMethod("close", &AudioSession::Close),
+        InstanceAccessor("sampleRate", &AudioSession::GetSampleRate, nullptr),
+        InstanceAccessor("channels", &AudioSession::GetChannels, nullptr),
+        InstanceAccessor("sampleFormat", &AudioSession::GetSampleFormat, nullptr),
+        InstanceAccessor("duration", &AudioSession::GetDuration, nullptr),
+    });
+    constructor_ = Persistent(func);
+    constructor_.SuppressDestruct();
+    return func;
+}
+
+Object AudioSession::NewInstance(Napi::Env env, const std::shared_ptr<AudioDecoder> &decoder)
+{
+    std::shared_ptr<AudioDecoder> copy = decoder;
+    return constructor_.New({External<std::shared_ptr<AudioDecoder>>::New(env, &copy)});
+}
+
+AudioSession::AudioSession(const CallbackInfo &info) : ObjectWrap<AudioSession>(info)
+{
+    // 只能由 openAudio 创建
+    if (info.Length() < 1 || !info[0].IsExternal())
+    {
+        TypeError::New(info.Env(), "Use openAudio() to create an AudioSession").ThrowAsJavaScriptException();
+        return;
+    }
+    decoder_ = *info[0].As<External<std::shared_ptr<AudioDecoder>>>().Data();
+    // 只在 Open 成功后创建,此时还没有其他工作线程持有解码器;
+    // 这些参数之后不会改变 (seek 重新打开时算出的值相同),getter 直接读快照,不在主线程上等锁
+    sampleRate_ = decoder_->sampleRate;
+    channels_ = decoder_->channels;
+    duration_ = decoder_->duration;
+}
+
+// read(samples) -> Promise<{ pcm, samples, position, eof }>
+// samples 为每声道的采样数;position 为本次读取之后的位置(秒)
+Value AudioSession::Read(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsNumber() || info[0].As<Number>().Int32Value() <= 0)
+    {
+        TypeError::New(env, "Expected samples (positive number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+    SessionReadWorker *worker = new SessionReadWorker(decoder_, info[0].As<Number>().Int32Value(), deferred);
+    worker->Queue();
+    return deferred.Promise();
+}
+
+// seek(seconds) -> Promise<seconds>
+Value AudioSession::Seek(const CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsNumber() || info[0].As<Number>().DoubleValue() < 0)
+    {
+        TypeError::New(env, "Expected seconds (non-negative number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+    SessionSeekWorker *worker = new SessionSeekWorker(decoder_, info[0].As<Number>().DoubleValue(), deferred);
+    worker->Queue();
+    return deferred.Promise();
+}
+
+// close() -> Promise<void>,释放解码器等资源;之后的 read / seek 会被拒绝
+Value AudioSession::Close(const CallbackInfo &info)
+{
+    Promise::Deferred deferred = Promise::Deferred::New(info.Env());
+    SessionCloseWorker *worker = new SessionCloseWorker(decoder_, deferred);
+    worker->Queue();
+    return deferred.Promise();
+}
+
+Value AudioSession::GetSampleRate(const CallbackInfo &info)
+{
+    return Number::New(info.Env(), sampleRate_);
+}
+
+Value AudioSession::GetChannels(const CallbackInfo &info)
+{
+    return Number::New(info.Env(), channels_);
+}
+
+Value AudioSession::GetSampleFormat(const CallbackInfo &info)
+{
+    return String::New(info.Env(), PcmSampleFormatName(decoder_->SampleFormat()));
+}
+
+Value AudioSession::GetDuration(const CallbackInfo &info)
+{
+    return Number::New(info.Env(), duration_);
+}
+
+// openAudio(input, options?) -> Promise<AudioSession>
+// input: 文件路径或 Buffer
+// options: { sampleRate, channels, sampleFormat: 's16' | 's32' | 'f32' },默认沿用输入的采样率和声道数,输出 s16
+Value OpenAudio(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    MediaInput input;
+    ObjectReference inputRef;
+    if (info.Length() < 1 || !GetMediaInput(info[0], input, inputRef))
+    {
+        TypeError::New(env, "Expected input (string path or Buffer)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    SessionOptions options;
+    if (info.Length() >= 2 && info[1].IsObject())
+    {
+        Object opts = info[1].As<Object>();
+        if (opts.Has("sampleRate") && opts.Get("sampleRate").IsNumber())
+            options.sampleRate = opts.Get("sampleRate").As<Number>().Int32Value();
+        if (opts.Has("channels") && opts.Get("channels").IsNumber())
+        {
+            options.channels = opts.Get("channels").As<Number>().Int32Value();
+            if (options.channels < 1 || options.channels > 8)
+            {
+                TypeError::New(env, "channels must be between 1 and 8").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+        }
+        if (opts.Has("sampleFormat") && opts.Get("sampleFormat").IsString())
+        {
+            options.sampleFormat = ParsePcmSampleFormat(opts.Get("sampleFormat").As<String>().Utf8Value(), false);
+            if (options.sampleFormat == AV_SAMPLE_FMT_NONE)
+            {
+                TypeError::New(env, "Unsupported sampleFormat. Supported: s16, s32, f32").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+        }
+    }
+
+    std::shared_ptr<AudioDecoder> decoder = std::make_shared<AudioDecoder>(input, std::move(inputRef), options);
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+    OpenAudioWorker *worker = new OpenAudioWorker(decoder, deferred);
+    worker->Queue();
+    return deferred.Promise();
+}
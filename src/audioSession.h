@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+#include <memory>
+
+class AudioDecoder;
+
+// openAudio 返回的解码会话: 持有解复用器、解码器和重采样器,多次 read / seek 之间不重新打开
+// 所有方法都在工作线程上执行,同一会话上的操作互斥;需要确定顺序时等待前一个 Promise 再发起下一个
+class AudioSession : public ObjectWrap<AudioSession>
+{
+public:
+    static Function Init(Napi::Env env);
+    static Object NewInstance(Napi::Env env, const std::shared_ptr<AudioDecoder> &decoder);
+
+    AudioSession(const CallbackInfo &info);
+
+private:
+    Value Read(const CallbackInfo &info);
+    Value Seek(const CallbackInfo &info);
+    Value Close(const CallbackInfo &info);
+    Value GetSampleRate(const CallbackInfo &info);
+    Value GetChannels(const CallbackInfo &info);
+    Value GetSampleFormat(const CallbackInfo &info);
+    Value GetDuration(const CallbackInfo &info);
+
+    static FunctionReference constructor_;
+    std::shared_ptr<AudioDecoder> decoder_;
+    int sampleRate_ = 0;
+    int channels_ = 0;
+    double duration_ = 0;
+};
+
+// openAudio(input, options?) -> Promise<AudioSession>
+Value OpenAudio(const CallbackInfo &info);
@@ -0,0 +1,146 @@
+#include "concatAudio.h"
+#include "encodeBranch.h"
+
+// ===== Concat Async Worker =====
+class ConcatWorker : public AsyncWorker
+{
+public:
+    ConcatWorker(std::vector<MediaInput> &&inputs, std::vector<ObjectReference> &&inputRefs, const OutputSpec &spec,
+                 Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), inputs_(std::move(inputs)), inputRefs_(std::move(inputRefs)), spec_(spec),
+          deferred_(deferred), durations_(inputs_.size(), 0.0), sampleRate_(0),
+          trimmedHead_(0), trimmedTail_(0) {}
+
+    void Execute() override
+    {
+        EncodeBranch branch(spec_);
+        for (size_t i = 0; i < inputs_.size(); i++)
+        {
+            if (!AppendInput(branch, i))
+                return; // branch 析构时关闭输出
+        }
+        branch.Finish();
+        if (branch.Failed())
+        {
+            SetError(branch.Error());
+            return;
+        }
+        sampleRate_ = branch.SampleRate();
+        trimmedHead_ = branch.TrimmedHead();
+        trimmedTail_ = branch.TrimmedTail();
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        double total = 0;
+        Array inputs = Array::New(env, durations_.size());
+        for (size_t i = 0; i < durations_.size(); i++)
+        {
+            inputs.Set((uint32_t)i, Number::New(env, durations_[i]));
+            total += durations_[i];
+        }
+        Object res = Object::New(env);
+        res.Set("sampleRate", Number::New(env, sampleRate_));
+        res.Set("duration", Number::New(env, total));
+        res.Set("inputs", inputs);
+        if (spec_.trimSilence.enabled)
+            res.Set("trimmed", NewTrimmedObject(env, trimmedHead_, trimmedTail_));
+        deferred_.Resolve(res);
+    }
+
+    void OnError(const Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    // 解码第 index 个输入并送入编码分支;第一个输入决定编码器参数,之后只重新配置重采样器
+    bool AppendInput(EncodeBranch &branch, size_t index)
+    {
+        std::string prefix = "Input " + std::to_string(index) + ": ";
+        AVFormatContext *fmt = nullptr;
+        AVCodecContext *dec = nullptr;
+        int stream = -1;
+        std::string error;
+        if (!OpenDecodeInput(inputs_[index], nullptr, &fmt, &stream, &dec, error))
+        {
+            SetError(prefix + error);
+            return false;
+        }
+
+        bool ok = index == 0 ? branch.Open(dec) : branch.ChangeInput(dec);
+        int64_t samples = 0;
+        int sample_rate = dec->sample_rate;
+        if (ok)
+            samples = DecodeIntoBranch(fmt, stream, dec, branch, nullptr, sample_rate);
+        durations_[index] = sample_rate > 0 ? (double)samples / sample_rate : 0;
+
+        avcodec_free_context(&dec);
+        CloseMediaInput(&fmt);
+        if (branch.Failed())
+        {
+            SetError(prefix + branch.Error());
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<MediaInput> inputs_;
+    std::vector<ObjectReference> inputRefs_;
+    OutputSpec spec_;
+    Promise::Deferred deferred_;
+    std::vector<double> durations_;
+    int sampleRate_;
+    double trimmedHead_;
+    double trimmedTail_;
+};
+
+Value ConcatAudio(const CallbackInfo &info)
+{
+    Env env = info.Env();
+    if (info.Length() < 3 || !info[0].IsArray() || !info[1].IsString() || !info[2].IsString())
+    {
+        TypeError::New(env, "Expected inputs array, output path string and format string").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Array list = info[0].As<Array>();
+    std::vector<MediaInput> inputs(list.Length());
+    std::vector<ObjectReference> inputRefs(list.Length());
+    for (uint32_t i = 0; i < list.Length(); i++)
+    {
+        if (!GetMediaInput(list.Get(i), inputs[i], inputRefs[i]))
+        {
+            TypeError::New(env, "Each input must be a string path or Buffer").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+    if (inputs.empty())
+    {
+        TypeError::New(env, "inputs must not be empty").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // 复用 process() 输出项的解析和校验: options 上补上 type / path / format
+    std::string format = info[2].As<String>().Utf8Value();
+    Object desc = Object::New(env);
+    if (info.Length() >= 4 && info[3].IsObject())
+    {
+        Object opts = info[3].As<Object>();
+        Array keys = opts.GetPropertyNames();
+        for (uint32_t i = 0; i < keys.Length(); i++)
+            desc.Set(keys.Get(i), opts.Get(keys.Get(i)));
+    }
+    desc.Set("type", String::New(env, format == "silk" ? "silk" : "audio"));
+    desc.Set("path", info[1]);
+    desc.Set("format", String::New(env, format));
+    OutputSpec spec;
+    if (!ParseOutputSpec(env, desc, spec))
+        return env.Null();
+
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+    ConcatWorker *worker = new ConcatWorker(std::move(inputs), std::move(inputRefs), spec, deferred);
+    worker->Queue();
+    return deferred.Promise();
+}
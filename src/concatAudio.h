@@ -0,0 +1,11 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+
+// concat(inputs, output, format, options?) -> Promise<{ sampleRate, duration, inputs }>
+// inputs: 文件路径或 Buffer 的数组,按顺序依次解码,送入同一条 重采样 -> FIFO -> 编码 -> 复用 链路
+// format: 'silk' 或 decodeAudioToFmt 支持的格式 (mp3 / amr / wma / m4a / spx / ogg / wav / flac)
+// options: 同 process() 编码输出项的参数 (sampleRate / resampleQuality / bitrate / complexity / packetSize / dtx / trimSilence)
+// trimSilence 只裁整个拼接结果的首尾,输入之间的静音保留;结果中 trimmed 为 { head, tail } 秒数
+// 输出采样率未指定时按第一个输入选择;时间戳连续,同一时刻只打开一个输入,内存与输入个数无关
+Value ConcatAudio(const CallbackInfo &info);
@@ -1,12 +1,281 @@
 #include "convertFile.h"
+#include "audioCommon.h"
 #include <iostream>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// 解码一个数据包,经格式转换/重采样后编码,编码得到的数据包交给 emit
+// packet 为 nullptr 时冲刷解码器和编码器
+// 分配失败、编码器出错或 emit 返回 false (写出失败) 时返回 false;输入中无法解码的数据包照旧跳过
+static bool TranscodePacket(AVCodecContext *dec, AVCodecContext *enc, SwrContext *swr, SwsContext *sws,
+                            AVPacket *packet, AVFrame *frame, AVFrame *convertedFrame,
+                            const std::function<bool(AVPacket *)> &emit)
+{
+    AVPacket *outPacket = av_packet_alloc();
+    if (!outPacket)
+        return false;
+
+    auto encode = [&](AVFrame *frameToEncode) -> bool
+    {
+        // 编码器拒收的帧沿用原来的做法跳过
+        if (avcodec_send_frame(enc, frameToEncode) < 0)
+            return true;
+        int ret;
+        while ((ret = avcodec_receive_packet(enc, outPacket)) == 0)
+        {
+            bool written = emit(outPacket);
+            av_packet_unref(outPacket);
+            if (!written)
+                return false;
+        }
+        return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF;
+    };
+
+    bool ok = true;
+    if (avcodec_send_packet(dec, packet) == 0)
+    {
+        while (ok && avcodec_receive_frame(dec, frame) == 0)
+        {
+            AVFrame *frameToEncode = frame;
+
+            // 视频格式转换
+            if (sws)
+            {
+                convertedFrame->format = enc->pix_fmt;
+                convertedFrame->width = enc->width;
+                convertedFrame->height = enc->height;
+                if (av_frame_get_buffer(convertedFrame, 0) < 0)
+                {
+                    av_frame_unref(frame);
+                    ok = false;
+                    break;
+                }
+
+                sws_scale(sws,
+                          frame->data, frame->linesize, 0, frame->height,
+                          convertedFrame->data, convertedFrame->linesize);
+
+                convertedFrame->pts = frame->pts;
+                frameToEncode = convertedFrame;
+            }
+
+            // 音频重采样
+            if (swr)
+            {
+                int out_samples = av_rescale_rnd(
+                    swr_get_delay(swr, dec->sample_rate) + frame->nb_samples,
+                    enc->sample_rate,
+                    dec->sample_rate,
+                    AV_ROUND_UP);
+
+                convertedFrame->format = enc->sample_fmt;
+                convertedFrame->ch_layout = enc->ch_layout;
+                convertedFrame->sample_rate = enc->sample_rate;
+                convertedFrame->nb_samples = out_samples;
+                if (av_frame_get_buffer(convertedFrame, 0) < 0)
+                {
+                    av_frame_unref(frame);
+                    ok = false;
+                    break;
+                }
+
+                int converted = swr_convert(swr,
+                                            convertedFrame->data, out_samples,
+                                            (const uint8_t **)frame->data, frame->nb_samples);
+
+                if (converted > 0)
+                {
+                    convertedFrame->nb_samples = converted;
+                    convertedFrame->pts = av_rescale_q(frame->pts, dec->time_base, enc->time_base);
+                    frameToEncode = convertedFrame;
+                }
+            }
+
+            // 编码
+            ok = encode(frameToEncode);
+
+            av_frame_unref(convertedFrame);
+            av_frame_unref(frame);
+        }
+    }
+
+    // 冲刷编码器
+    if (ok && !packet)
+        ok = encode(nullptr);
+
+    av_packet_free(&outPacket);
+    return ok;
+}
+
+// 并行转码时一条流的工作线程: 从输入队列取数据包转码,结果放入输出队列由解复用线程写出
+// 两个队列都有上限;工作线程出错或解复用线程中止时双方都不再等待
+struct StreamTask
+{
+    AVCodecContext *dec = nullptr;
+    AVCodecContext *enc = nullptr;
+    SwrContext *swr = nullptr;
+    SwsContext *sws = nullptr;
+    int outIndex = -1;
+    AVRational outTimeBase = {0, 1};
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<AVPacket *> input;
+    std::deque<AVPacket *> output;
+    bool eof = false;
+    bool aborted = false; // 解复用线程出错,要求工作线程尽快退出
+    bool failed = false;  // 工作线程转码失败
+    bool done = false;    // 工作线程已退出,之后不会再有输出
+
+    static const size_t MAX_QUEUED_PACKETS = 32; // 输入/输出队列上限,限制内存占用
+
+    ~StreamTask()
+    {
+        for (AVPacket *pkt : input)
+            av_packet_free(&pkt);
+        for (AVPacket *pkt : output)
+            av_packet_free(&pkt);
+    }
+
+    void Run()
+    {
+        AVFrame *frame = av_frame_alloc();
+        AVFrame *convertedFrame = av_frame_alloc();
+        // 输出队列满时等待解复用线程取走
+        auto emit = [&](AVPacket *pkt) -> bool
+        {
+            AVPacket *out = av_packet_alloc();
+            if (!out)
+                return false;
+            av_packet_move_ref(out, pkt);
+            out->stream_index = outIndex;
+            av_packet_rescale_ts(out, enc->time_base, outTimeBase);
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [&]
+                      { return output.size() < MAX_QUEUED_PACKETS || aborted; });
+            if (aborted)
+            {
+                av_packet_free(&out);
+                return false;
+            }
+            output.push_back(out);
+            lock.unlock();
+            cond.notify_all();
+            return true;
+        };
+
+        bool ok = frame && convertedFrame;
+        bool flush = false;
+        while (ok)
+        {
+            AVPacket *packet = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [&]
+                          { return !input.empty() || eof || aborted; });
+                if (aborted || input.empty())
+                {
+                    flush = !aborted;
+                    break;
+                }
+                packet = input.front();
+                input.pop_front();
+            }
+            cond.notify_all();
+            ok = TranscodePacket(dec, enc, swr, sws, packet, frame, convertedFrame, emit);
+            av_packet_free(&packet);
+        }
+
+        if (ok && flush)
+            ok = TranscodePacket(dec, enc, swr, sws, nullptr, frame, convertedFrame, emit);
+        av_frame_free(&convertedFrame);
+        av_frame_free(&frame);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            failed = !ok;
+            done = true;
+        }
+        cond.notify_all();
+    }
+
+    // 解复用线程: 提交一个数据包,输入队列满时等待
+    // 等待期间输出队列也满了 (工作线程在等写出) 或工作线程已退出时返回 false,调用方写出已编码的数据包后重试
+    bool Push(AVPacket *packet)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&]
+                  { return input.size() < MAX_QUEUED_PACKETS || output.size() >= MAX_QUEUED_PACKETS || done; });
+        if (input.size() >= MAX_QUEUED_PACKETS || done)
+            return false;
+        input.push_back(packet);
+        lock.unlock();
+        cond.notify_all();
+        return true;
+    }
+
+    // 解复用线程: 输入结束,工作线程冲刷编码器后退出
+    void Finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            eof = true;
+        }
+        cond.notify_all();
+    }
+
+    // 解复用线程: 写出失败,工作线程丢弃剩余输入后退出
+    void Abort()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            aborted = true;
+        }
+        cond.notify_all();
+    }
+
+    // 解复用线程: 取出已编码的数据包
+    void TakeOutput(std::deque<AVPacket *> &ready)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.swap(output);
+        }
+        cond.notify_all();
+    }
+
+    // 解复用线程: 等到有已编码的数据包或工作线程退出后取出数据包,返回工作线程是否已退出
+    bool WaitOutput(std::deque<AVPacket *> &ready)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&]
+                  { return !output.empty() || done; });
+        ready.swap(output);
+        bool exited = done;
+        lock.unlock();
+        cond.notify_all();
+        return exited;
+    }
+
+    bool Failed()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return failed;
+    }
+};
 
 // ===== ConvertFile Async Worker =====
 class ConvertFileWorker : public AsyncWorker
 {
 public:
-    ConvertFileWorker(const std::string &inputPath, const std::string &outputPath, const std::string &outputFormat, Promise::Deferred deferred)
-        : AsyncWorker(deferred.Env()), inputPath_(inputPath), outputPath_(outputPath), outputFormat_(outputFormat), deferred_(deferred) {}
+    ConvertFileWorker(const std::string &inputPath, const std::string &outputPath, const std::string &outputFormat, const std::string &mode,
+                      const std::vector<std::string> &streamSpecs, bool parallel, ResampleQuality quality, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), inputPath_(inputPath), outputPath_(outputPath), outputFormat_(outputFormat), mode_(mode),
+          streamSpecs_(streamSpecs), parallel_(parallel), quality_(quality), deferred_(deferred), copiedStreams_(0), transcodedStreams_(0) {}
 
     void Execute() override
     {
@@ -16,6 +285,11 @@ public:
         AVCodecContext **encCtxArray = nullptr;
         SwrContext **swrArray = nullptr;
         SwsContext **swsArray = nullptr;
+        int *outIndexArray = nullptr; // 输入流 -> 输出流索引, -1 表示不输出
+        bool *copyArray = nullptr;    // 该流是否直接复制数据包(不解码)
+        bool *selectedArray = nullptr; // 该流是否被选中输出
+        StreamTask *taskArray = nullptr; // 并行转码时每条流的工作线程
+        bool outputFailed = false;       // 编码或写出失败,停止解复用
         unsigned int streamCount = 0;
 
         // 打开输入文件
@@ -46,22 +320,95 @@ public:
         encCtxArray = new (std::nothrow) AVCodecContext *[streamCount]();
         swrArray = new (std::nothrow) SwrContext *[streamCount]();
         swsArray = new (std::nothrow) SwsContext *[streamCount]();
+        outIndexArray = new (std::nothrow) int[streamCount];
+        copyArray = new (std::nothrow) bool[streamCount]();
+        selectedArray = new (std::nothrow) bool[streamCount]();
         
-        if (!decCtxArray || !encCtxArray || !swrArray || !swsArray)
+        if (!decCtxArray || !encCtxArray || !swrArray || !swsArray || !outIndexArray || !copyArray || !selectedArray)
         {
             SetError("Failed to allocate context arrays");
             goto cleanup;
         }
 
+        // 选择输出流: 未指定时输出全部音频流,否则按流说明符 (例如 "a:0", "a:1") 选择
+        for (unsigned int i = 0; i < streamCount; i++)
+        {
+            outIndexArray[i] = -1;
+            selectedArray[i] = streamSpecs_.empty() && inFmt->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO;
+        }
+        for (const std::string &spec : streamSpecs_)
+        {
+            bool matched = false;
+            for (unsigned int i = 0; i < streamCount; i++)
+            {
+                int ret = avformat_match_stream_specifier(inFmt, inFmt->streams[i], spec.c_str());
+                if (ret < 0)
+                {
+                    SetError("Invalid stream specifier: " + spec);
+                    goto cleanup;
+                }
+                if (ret > 0)
+                {
+                    selectedArray[i] = true;
+                    matched = true;
+                }
+            }
+            if (!matched)
+            {
+                SetError("Stream specifier matches no streams: " + spec);
+                goto cleanup;
+            }
+        }
+
+        // 未选中的流在解复用层直接丢弃,不再读取其数据
+        for (unsigned int i = 0; i < streamCount; i++)
+        {
+            if (!selectedArray[i])
+            {
+                inFmt->streams[i]->discard = AVDISCARD_ALL;
+            }
+        }
+
         // 为每个输入流创建对应的输出流
         for (unsigned int i = 0; i < streamCount; i++)
         {
             AVStream *inStream = inFmt->streams[i];
             AVCodecParameters *inCodecPar = inStream->codecpar;
 
-            // 跳过非音频流
-            if (inCodecPar->codec_type != AVMEDIA_TYPE_AUDIO)
+            if (!selectedArray[i])
+            {
+                continue;
+            }
+
+            // 输出容器可以直接承载输入编码时,复制数据包而不转码
+            bool canCopy = avformat_query_codec(outFmt->oformat, inCodecPar->codec_id, FF_COMPLIANCE_NORMAL) == 1;
+            if (inCodecPar->codec_type != AVMEDIA_TYPE_AUDIO && (!canCopy || mode_ == "transcode"))
+            {
+                // 只支持音频转码,其它类型的流只能直接复制
+                SetError(std::string("Stream ") + std::to_string(i) + " (" + av_get_media_type_string(inCodecPar->codec_type) +
+                         ") can only be stream-copied, and format " + outFmt->oformat->name + " cannot hold it");
+                goto cleanup;
+            }
+            if (mode_ == "copy" && !canCopy)
             {
+                SetError(std::string("Codec ") + avcodec_get_name(inCodecPar->codec_id) +
+                         " cannot be stream-copied into format " + outFmt->oformat->name);
+                goto cleanup;
+            }
+            if (canCopy && mode_ != "transcode")
+            {
+                AVStream *outStream = avformat_new_stream(outFmt, nullptr);
+                if (!outStream || avcodec_parameters_copy(outStream->codecpar, inCodecPar) < 0)
+                {
+                    SetError("Failed to create output stream");
+                    goto cleanup;
+                }
+                outStream->codecpar->codec_tag = 0; // 由目标容器重新选择 tag
+                outStream->time_base = inStream->time_base;
+                outIndexArray[i] = outStream->index;
+                copyArray[i] = true;
+                copiedStreams_++;
+                streamMap_.push_back({(int)i, outStream->index, true});
                 continue;
             }
 
@@ -122,7 +469,13 @@ public:
                     avcodec_free_context(&decCtxArray[i]);
                     continue;
                 }
+                outStream->codecpar->codec_tag = 0;
                 outStream->time_base = inStream->time_base;
+                outIndexArray[i] = outStream->index;
+                copyArray[i] = true;
+                copiedStreams_++;
+                streamMap_.push_back({(int)i, outStream->index, true});
+                avcodec_free_context(&decCtxArray[i]);
                 continue;
             }
 
@@ -191,6 +544,7 @@ public:
                                         0, nullptr);
                     if (swrArray[i])
                     {
+                        ApplyResampleQuality(swrArray[i], quality_);
                         swr_init(swrArray[i]);
                     }
                 }
@@ -213,6 +567,15 @@ public:
             }
 
             outStream->time_base = encCtxArray[i]->time_base;
+            outIndexArray[i] = outStream->index;
+            transcodedStreams_++;
+            streamMap_.push_back({(int)i, outStream->index, false});
+        }
+
+        if (outFmt->nb_streams == 0)
+        {
+            SetError("No selected stream could be converted");
+            goto cleanup;
         }
 
         // 打开输出文件
@@ -238,146 +601,186 @@ public:
             AVFrame *frame = av_frame_alloc();
             AVFrame *convertedFrame = av_frame_alloc();
 
-            while (av_read_frame(inFmt, packet) >= 0)
+            // 写出已编码的数据包
+            auto writeEncoded = [&](AVPacket *pkt, unsigned int streamIndex) -> bool
+            {
+                pkt->stream_index = outIndexArray[streamIndex];
+                av_packet_rescale_ts(pkt, encCtxArray[streamIndex]->time_base, outFmt->streams[outIndexArray[streamIndex]]->time_base);
+                return av_interleaved_write_frame(outFmt, pkt) >= 0;
+            };
+
+            // 两条及以上转码流时,每条流在独立线程上解码/重采样/编码,本线程只负责解复用和写出
+            int transcodeCount = 0;
+            for (unsigned int i = 0; i < streamCount; i++)
+            {
+                if (outIndexArray[i] >= 0 && !copyArray[i] && encCtxArray[i])
+                    transcodeCount++;
+            }
+            if (parallel_ && transcodeCount > 1)
+            {
+                taskArray = new (std::nothrow) StreamTask[streamCount];
+            }
+            if (taskArray)
+            {
+                // 由复用器按 DTS 交错各流,等待所有流都有数据后再写出
+                outFmt->max_interleave_delta = 0;
+                for (unsigned int i = 0; i < streamCount; i++)
+                {
+                    if (outIndexArray[i] < 0 || copyArray[i] || !encCtxArray[i])
+                        continue;
+                    StreamTask &task = taskArray[i];
+                    task.dec = decCtxArray[i];
+                    task.enc = encCtxArray[i];
+                    task.swr = swrArray[i];
+                    task.sws = swsArray[i];
+                    task.outIndex = outIndexArray[i];
+                    task.outTimeBase = outFmt->streams[outIndexArray[i]]->time_base;
+                    task.thread = std::thread(&StreamTask::Run, &task);
+                }
+            }
+
+            // 把工作线程已编码的数据包交给复用器;已经失败时只释放
+            std::deque<AVPacket *> ready;
+            auto writeReady = [&]()
+            {
+                for (AVPacket *pkt : ready)
+                {
+                    if (!outputFailed && av_interleaved_write_frame(outFmt, pkt) < 0)
+                        outputFailed = true;
+                    av_packet_free(&pkt);
+                }
+                ready.clear();
+            };
+            auto drainTasks = [&]()
+            {
+                for (unsigned int i = 0; taskArray && i < streamCount; i++)
+                {
+                    taskArray[i].TakeOutput(ready);
+                    writeReady();
+                    if (taskArray[i].Failed())
+                        outputFailed = true;
+                }
+            };
+
+            while (!outputFailed && av_read_frame(inFmt, packet) >= 0)
             {
                 unsigned int streamIndex = packet->stream_index;
-                AVStream *inStream = inFmt->streams[streamIndex];
 
-                // 跳过非音频流的数据包
-                if (inStream->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
+                // 跳过没有输出的流
+                if (streamIndex >= streamCount || outIndexArray[streamIndex] < 0)
                 {
                     av_packet_unref(packet);
                     continue;
                 }
 
-                AVStream *outStream = outFmt->streams[streamIndex];
+                AVStream *inStream = inFmt->streams[streamIndex];
+                int outIndex = outIndexArray[streamIndex];
+                AVStream *outStream = outFmt->streams[outIndex];
 
-                // 如果该流没有编码器（直接复制流）
-                if (!encCtxArray[streamIndex])
+                // 直接复制数据包(remux)
+                if (copyArray[streamIndex])
                 {
                     av_packet_rescale_ts(packet, inStream->time_base, outStream->time_base);
-                    packet->stream_index = streamIndex;
-                    av_interleaved_write_frame(outFmt, packet);
-                    av_packet_unref(packet);
-                    continue;
+                    packet->stream_index = outIndex;
+                    packet->pos = -1;
+                    if (inStream->codecpar->codec_id == AV_CODEC_ID_NTSILK_S16LE)
+                    {
+                        // SILK 数据包需要补回长度前缀
+                        AVPacket *silkPacket = av_packet_alloc();
+                        if (!silkPacket || SilkPacketForMuxer(packet, silkPacket) < 0 ||
+                            av_interleaved_write_frame(outFmt, silkPacket) < 0)
+                            outputFailed = true;
+                        av_packet_free(&silkPacket);
+                        av_packet_unref(packet);
+                    }
+                    else if (av_interleaved_write_frame(outFmt, packet) < 0)
+                    {
+                        outputFailed = true;
+                    }
                 }
-
-                // 解码
-                if (avcodec_send_packet(decCtxArray[streamIndex], packet) == 0)
+                else if (taskArray)
                 {
-                    while (avcodec_receive_frame(decCtxArray[streamIndex], frame) == 0)
+                    // 交给该流的工作线程;它在等输出队列腾出空间时先写出再重试
+                    AVPacket *queued = av_packet_alloc();
+                    if (!queued)
+                    {
+                        outputFailed = true;
+                    }
+                    else
                     {
-                        AVFrame *frameToEncode = frame;
-
-                        // 视频格式转换
-                        if (swsArray[streamIndex])
-                        {
-                            convertedFrame->format = encCtxArray[streamIndex]->pix_fmt;
-                            convertedFrame->width = encCtxArray[streamIndex]->width;
-                            convertedFrame->height = encCtxArray[streamIndex]->height;
-                            av_frame_get_buffer(convertedFrame, 0);
-
-                            sws_scale(swsArray[streamIndex],
-                                      frame->data, frame->linesize, 0, frame->height,
-                                      convertedFrame->data, convertedFrame->linesize);
-
-                            convertedFrame->pts = frame->pts;
-                            frameToEncode = convertedFrame;
-                        }
-
-                        // 音频重采样
-                        if (swrArray[streamIndex])
-                        {
-                            int out_samples = av_rescale_rnd(
-                                swr_get_delay(swrArray[streamIndex], decCtxArray[streamIndex]->sample_rate) + frame->nb_samples,
-                                encCtxArray[streamIndex]->sample_rate,
-                                decCtxArray[streamIndex]->sample_rate,
-                                AV_ROUND_UP);
-
-                            convertedFrame->format = encCtxArray[streamIndex]->sample_fmt;
-                            convertedFrame->ch_layout = encCtxArray[streamIndex]->ch_layout;
-                            convertedFrame->sample_rate = encCtxArray[streamIndex]->sample_rate;
-                            convertedFrame->nb_samples = out_samples;
-                            av_frame_get_buffer(convertedFrame, 0);
-
-                            int converted = swr_convert(swrArray[streamIndex],
-                                                        convertedFrame->data, out_samples,
-                                                        (const uint8_t **)frame->data, frame->nb_samples);
-
-                            if (converted > 0)
-                            {
-                                convertedFrame->nb_samples = converted;
-                                convertedFrame->pts = av_rescale_q(frame->pts, decCtxArray[streamIndex]->time_base, encCtxArray[streamIndex]->time_base);
-                                frameToEncode = convertedFrame;
-                            }
-                        }
-
-                        // 编码
-                        if (avcodec_send_frame(encCtxArray[streamIndex], frameToEncode) == 0)
-                        {
-                            AVPacket *outPacket = av_packet_alloc();
-                            while (avcodec_receive_packet(encCtxArray[streamIndex], outPacket) == 0)
-                            {
-                                outPacket->stream_index = streamIndex;
-                                av_packet_rescale_ts(outPacket, encCtxArray[streamIndex]->time_base, outStream->time_base);
-                                av_interleaved_write_frame(outFmt, outPacket);
-                                av_packet_unref(outPacket);
-                            }
-                            av_packet_free(&outPacket);
-                        }
-
-                        av_frame_unref(convertedFrame);
-                        av_frame_unref(frame);
+                        av_packet_move_ref(queued, packet);
+                        while (!outputFailed && !taskArray[streamIndex].Push(queued))
+                            drainTasks();
+                        if (outputFailed)
+                            av_packet_free(&queued);
                     }
                 }
+                else
+                {
+                    if (!TranscodePacket(decCtxArray[streamIndex], encCtxArray[streamIndex], swrArray[streamIndex], swsArray[streamIndex],
+                                         packet, frame, convertedFrame,
+                                         [&](AVPacket *pkt)
+                                         { return writeEncoded(pkt, streamIndex); }))
+                        outputFailed = true;
+                }
 
                 av_packet_unref(packet);
+                drainTasks();
             }
 
             // Flush 解码器和编码器
             for (unsigned int i = 0; i < streamCount; i++)
             {
-                if (decCtxArray[i] && encCtxArray[i])
+                if (decCtxArray[i] && encCtxArray[i] && outIndexArray[i] >= 0 && !copyArray[i])
                 {
-                    avcodec_send_packet(decCtxArray[i], nullptr);
-                    while (avcodec_receive_frame(decCtxArray[i], frame) == 0)
+                    if (taskArray)
                     {
-                        avcodec_send_frame(encCtxArray[i], frame);
-                        AVPacket *outPacket = av_packet_alloc();
-                        while (avcodec_receive_packet(encCtxArray[i], outPacket) == 0)
-                        {
-                            outPacket->stream_index = i;
-                            av_packet_rescale_ts(outPacket, encCtxArray[i]->time_base, outFmt->streams[i]->time_base);
-                            av_interleaved_write_frame(outFmt, outPacket);
-                            av_packet_unref(outPacket);
-                        }
-                        av_packet_free(&outPacket);
-                        av_frame_unref(frame);
+                        if (outputFailed)
+                            taskArray[i].Abort();
+                        else
+                            taskArray[i].Finish();
                     }
-
-                    avcodec_send_frame(encCtxArray[i], nullptr);
-                    AVPacket *outPacket = av_packet_alloc();
-                    while (avcodec_receive_packet(encCtxArray[i], outPacket) == 0)
+                    else if (!outputFailed &&
+                             !TranscodePacket(decCtxArray[i], encCtxArray[i], swrArray[i], swsArray[i],
+                                              nullptr, frame, convertedFrame,
+                                              [&](AVPacket *pkt)
+                                              { return writeEncoded(pkt, i); }))
                     {
-                        outPacket->stream_index = i;
-                        av_packet_rescale_ts(outPacket, encCtxArray[i]->time_base, outFmt->streams[i]->time_base);
-                        av_interleaved_write_frame(outFmt, outPacket);
-                        av_packet_unref(outPacket);
+                        outputFailed = true;
                     }
-                    av_packet_free(&outPacket);
                 }
             }
+            // 冲刷期间持续写出,工作线程不会因输出队列满而卡住
+            for (unsigned int i = 0; taskArray && i < streamCount; i++)
+            {
+                if (!taskArray[i].thread.joinable())
+                    continue;
+                while (!taskArray[i].WaitOutput(ready))
+                    writeReady();
+                writeReady();
+                if (taskArray[i].Failed())
+                    outputFailed = true;
+                taskArray[i].thread.join();
+            }
 
             av_frame_free(&convertedFrame);
             av_frame_free(&frame);
             av_packet_free(&packet);
         }
 
-        // 写入文件尾
-        av_write_trailer(outFmt);
+        // 写入文件尾;编码或写出失败时文件已不完整,不写文件尾
+        if (outputFailed)
+            SetError("Failed to encode or write output");
+        else if (av_write_trailer(outFmt) < 0)
+            SetError("Failed to write trailer");
 
     cleanup:
-        // 清理资源
+        // 清理资源 (工作线程此时均已结束)
+        delete[] taskArray;
+        delete[] outIndexArray;
+        delete[] copyArray;
+        delete[] selectedArray;
+
         if (swsArray)
         {
             for (unsigned int i = 0; i < streamCount; i++)
@@ -434,6 +837,20 @@ public:
         Napi::Env env = Env();
         Object res = Object::New(env);
         res.Set("success", Boolean::New(env, true));
+        res.Set("copiedStreams", Number::New(env, copiedStreams_));
+        res.Set("transcodedStreams", Number::New(env, transcodedStreams_));
+
+        // 输入 -> 输出流映射
+        Array streams = Array::New(env, streamMap_.size());
+        for (size_t i = 0; i < streamMap_.size(); i++)
+        {
+            Object entry = Object::New(env);
+            entry.Set("input", Number::New(env, streamMap_[i].input));
+            entry.Set("output", Number::New(env, streamMap_[i].output));
+            entry.Set("copy", Boolean::New(env, streamMap_[i].copy));
+            streams.Set((uint32_t)i, entry);
+        }
+        res.Set("streams", streams);
         deferred_.Resolve(res);
     }
 
@@ -446,7 +863,21 @@ private:
     std::string inputPath_;
     std::string outputPath_;
     std::string outputFormat_;
+    std::string mode_;
+    std::vector<std::string> streamSpecs_;
+    bool parallel_;
+    ResampleQuality quality_;
     Promise::Deferred deferred_;
+    int copiedStreams_;
+    int transcodedStreams_;
+
+    struct StreamMapEntry
+    {
+        int input;
+        int output;
+        bool copy;
+    };
+    std::vector<StreamMapEntry> streamMap_;
 };
 
 Value ConvertFile(const CallbackInfo &info)
@@ -463,8 +894,51 @@ Value ConvertFile(const CallbackInfo &info)
     std::string outputPath = info[1].As<String>().Utf8Value();
     std::string outputFormat = info[2].As<String>().Utf8Value();
 
+    // 第四个参数可选: { mode: 'auto' | 'copy' | 'transcode', streams: ['a:0', 'a:1'], parallel: true,
+    //                resampleQuality: 'fast' | 'default' | 'high' }
+    std::string mode = "auto";
+    std::vector<std::string> streamSpecs;
+    bool parallel = true;
+    ResampleQuality quality = ResampleQuality::Default;
+    if (info.Length() >= 4 && info[3].IsObject())
+    {
+        Object opts = info[3].As<Object>();
+        if (opts.Has("streams") && opts.Get("streams").IsArray())
+        {
+            Array streams = opts.Get("streams").As<Array>();
+            for (uint32_t i = 0; i < streams.Length(); i++)
+            {
+                if (!streams.Get(i).IsString())
+                {
+                    TypeError::New(env, "streams must be an array of stream specifier strings").ThrowAsJavaScriptException();
+                    return env.Null();
+                }
+                streamSpecs.push_back(streams.Get(i).As<String>().Utf8Value());
+            }
+        }
+        if (opts.Has("mode") && opts.Get("mode").IsString())
+        {
+            mode = opts.Get("mode").As<String>().Utf8Value();
+        }
+        if (opts.Has("parallel"))
+        {
+            parallel = opts.Get("parallel").ToBoolean().Value();
+        }
+        if (opts.Has("resampleQuality") && opts.Get("resampleQuality").IsString() &&
+            !ParseResampleQuality(opts.Get("resampleQuality").As<String>().Utf8Value(), quality))
+        {
+            TypeError::New(env, "resampleQuality must be 'fast', 'default' or 'high'").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (mode != "auto" && mode != "copy" && mode != "transcode")
+        {
+            TypeError::New(env, "Unsupported mode. Supported: auto, copy, transcode").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
     Promise::Deferred deferred = Promise::Deferred::New(env);
-    ConvertFileWorker *worker = new ConvertFileWorker(inputPath, outputPath, outputFormat, deferred);
+    ConvertFileWorker *worker = new ConvertFileWorker(inputPath, outputPath, outputFormat, mode, streamSpecs, parallel, quality, deferred);
     worker->Queue();
     return deferred.Promise();
 }
@@ -3,11 +3,17 @@
 
 #include "ffmpegCommon.h"
 
-// convertFile(inputPath, outputPath, outputFormat) -> Promise
+// convertFile(inputPath, outputPath, outputFormat, options?) -> Promise
 // 将任意文件转换为指定格式
 // inputPath: 输入文件路径
 // outputPath: 输出文件路径
 // outputFormat: 输出格式 (例如: "mp3", "wav", "mp4", "avi" 等)
+// options.mode: "auto" (默认,容器支持输入编码时直接复制数据包,否则转码)
+//               "copy" (只复制,不支持时报错) / "transcode" (总是转码)
+// options.streams: 流说明符数组 (例如 ["a:0", "a:1"]),默认全部音频流;
+//                  未选中的流在解复用层丢弃 (AVDISCARD_ALL),非音频流只能直接复制
+// options.parallel: 默认 true,两条及以上转码流时每条流在独立线程上转码,由复用器按 DTS 交错写出
+// 结果中的 streams 给出 { input, output, copy } 映射
 Value ConvertFile(const CallbackInfo &info);
 
 #endif // CONVERTFILE_H
@@ -1,16 +1,111 @@
 #include "convertNTSilk.h"
+#include "audioCommon.h"
+#include "encodeBranch.h"
+#include "framePipeline.h"
+#include "sampleConvert.h"
 #include <iostream>
+#include <memory>
 #include <algorithm>
 
+extern "C"
+{
+#include "SKP_Silk_SDK_API.h"
+}
+
+// 编码器输入采样率的选择策略
+enum class SilkRatePolicy
+{
+    Internal, // 直接重采样到 SILK 内部编码采样率,只做一次重采样
+    Nearest,  // 选择与输入最接近的支持采样率,由 SILK 前端再降到内部采样率(旧行为)
+};
+
+// SILK 编码参数 (对应 ntsilk 编码器的 AVOption)
+struct SilkEncodeOptions
+{
+    int complexity = 2;   // 0 最快, 2 质量最好
+    int bitrate = 30000;  // bps
+    bool dtx = false;     // 静音帧不编码
+    bool fec = false;     // 带内前向纠错
+    int packetLoss = 0;   // 预期丢包率(%)
+    int packetSize = 20;  // 每包时长(ms): 20/40/60/80/100
+    SilkRatePolicy ratePolicy = SilkRatePolicy::Internal;
+    bool bitrateSet = false;    // 显式指定了 bitrate,输入为 SILK 时作为码率上限
+    bool packetSizeSet = false; // 显式指定了 packetSize,输入为 SILK 时要求包长一致
+    bool reencode = false;      // 输入已是 SILK 时也强制重新编码
+    bool pipeline = false;      // 解码和编码分别在两个线程上运行
+    ResampleQuality resampleQuality = ResampleQuality::Default;
+    double start = 0;           // 起始时间(秒)
+    double duration = 0;        // 时长(秒),0 表示到结尾
+    double segment = 0;         // 分段时长(秒),0 表示输出单个文件
+    SilenceTrimOptions trimSilence; // 编码前裁掉首尾静音
+};
+
+// 已是 SILK 的输入的码流统计 (由每包的 TOC 得到,不解码)
+struct SilkStreamStats
+{
+    int64_t frames = 0;     // 20ms 帧数
+    int64_t bytes = 0;      // 负载字节数,不含长度前缀
+    int maxRate = 0;        // 最高内部采样率 (Hz)
+    int framesPerPacket = 0; // 首个非空包的帧数
+    bool corrupt = false;
+};
+
+// 扫描 SILK 输入的每个数据包,统计时长、码率和内部采样率
+static bool ScanSilkStream(const std::string &path, SilkStreamStats &stats)
+{
+    AVFormatContext *fmt = nullptr;
+    if (avformat_open_input(&fmt, path.c_str(), nullptr, nullptr) < 0)
+        return false;
+
+    AVPacket *pkt = av_packet_alloc();
+    while (pkt && av_read_frame(fmt, pkt) >= 0)
+    {
+        if (pkt->size <= 1)
+        {
+            // DTX 空帧,时长按一帧计
+            stats.frames++;
+        }
+        else
+        {
+            SKP_Silk_TOC_struct toc;
+            SKP_Silk_SDK_get_TOC(pkt->data, (SKP_int16)pkt->size, &toc);
+            if (toc.corrupt || toc.framesInPacket <= 0)
+            {
+                stats.corrupt = true;
+                av_packet_unref(pkt);
+                break;
+            }
+            stats.frames += toc.framesInPacket;
+            stats.bytes += pkt->size;
+            stats.maxRate = std::max(stats.maxRate, toc.fs_kHz * 1000);
+            if (stats.framesPerPacket == 0)
+                stats.framesPerPacket = toc.framesInPacket;
+        }
+        av_packet_unref(pkt);
+    }
+    av_packet_free(&pkt);
+    avformat_close_input(&fmt);
+    return true;
+}
+
 // ===== ConvertToNTSilkTct Async Worker =====
 class ConvertToNTSilkTctWorker : public AsyncWorker
 {
 public:
-    ConvertToNTSilkTctWorker(const std::string &inPath, const std::string &outPath, Promise::Deferred deferred)
-        : AsyncWorker(deferred.Env()), inPath_(inPath), outPath_(outPath), deferred_(deferred) {}
+    ConvertToNTSilkTctWorker(const std::string &inPath, const std::string &outPath, const SilkEncodeOptions &options, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), inPath_(inPath), outPath_(outPath), options_(options), deferred_(deferred), copied_(false),
+          trimmedHead_(0), trimmedTail_(0) {}
 
     void Execute() override
     {
+        // 分段输出 (如平台 60 秒语音上限) / 静音裁剪: 一次解码,
+        // 在采样精确的边界处轮换编码器和复用器,首尾静音在进入编码器前裁掉
+        if (options_.segment > 0 || options_.trimSilence.enabled)
+        {
+            ExecuteBranch();
+            return;
+        }
+
         // 打开输入文件
         AVFormatContext *inFmt = nullptr;
         if (avformat_open_input(&inFmt, inPath_.c_str(), nullptr, nullptr) < 0)
@@ -51,8 +146,16 @@ public:
             return;
         }
 
-        // 初始化解码器
+        // 输入已经是 SILK 且满足码率/包长约束时,只改写文件头,数据包原样复制
         AVStream *inSt = inFmt->streams[audioStream];
+        if (inSt->codecpar->codec_id == AV_CODEC_ID_NTSILK_S16LE && CanCopySilk())
+        {
+            CopySilk(inFmt, audioStream);
+            avformat_close_input(&inFmt);
+            return;
+        }
+
+        // 初始化解码器
         const AVCodec *dec = avcodec_find_decoder(inSt->codecpar->codec_id);
         if (!dec)
         {
@@ -100,17 +203,39 @@ public:
             }
         }
 
+        // 直接重采样到 SILK 内部采样率: swr 在较低采样率下工作,SILK 前端也无需再重采样
+        if (options_.ratePolicy == SilkRatePolicy::Internal)
+        {
+            target_rate = std::min(target_rate, SilkInternalSampleRate(options_.bitrate));
+        }
+
+        // 单声道且已是目标采样率 (如 24k 单声道 WAV) 时只需转换采样格式,s16 输入就是一次 memcpy
+        SampleConvertFn convert = nullptr;
+        if (decCtx->ch_layout.nb_channels == 1 && decCtx->sample_rate == target_rate)
+        {
+            convert = FindSampleConverter(decCtx->sample_fmt, AV_SAMPLE_FMT_S16);
+        }
+
         // 初始化重采样器(统一转换为单声道 S16 目标采样率)
-        SwrContext *swr = swr_alloc();
+        SwrContext *swr = nullptr;
         AVChannelLayout in_ch_layout = decCtx->ch_layout;
         AVChannelLayout out_ch_layout;
         av_channel_layout_default(&out_ch_layout, 1); // 单声道
 
-        if (swr_alloc_set_opts2(&swr,
-                                &out_ch_layout, AV_SAMPLE_FMT_S16, target_rate,
-                                &in_ch_layout, decCtx->sample_fmt, decCtx->sample_rate,
-                                0, nullptr) < 0 ||
-            swr_init(swr) < 0)
+        bool swr_failed = false;
+        if (!convert)
+        {
+            swr_failed = swr_alloc_set_opts2(&swr,
+                                             &out_ch_layout, AV_SAMPLE_FMT_S16, target_rate,
+                                             &in_ch_layout, decCtx->sample_fmt, decCtx->sample_rate,
+                                             0, nullptr) < 0;
+            if (!swr_failed)
+            {
+                ApplyResampleQuality(swr, options_.resampleQuality);
+                swr_failed = swr_init(swr) < 0;
+            }
+        }
+        if (swr_failed)
         {
             if (swr)
                 swr_free(&swr);
@@ -136,9 +261,18 @@ public:
         encCtx->sample_fmt = AV_SAMPLE_FMT_S16;
         av_channel_layout_default(&encCtx->ch_layout, 1); // 单声道
         encCtx->time_base = {1, target_rate};
+        encCtx->bit_rate = options_.bitrate;
 
-        if (avcodec_open2(encCtx, enc, nullptr) < 0)
+        AVDictionary *encOpts = nullptr;
+        av_dict_set_int(&encOpts, "complexity", options_.complexity, 0);
+        av_dict_set_int(&encOpts, "dtx", options_.dtx ? 1 : 0, 0);
+        av_dict_set_int(&encOpts, "fec", options_.fec ? 1 : 0, 0);
+        av_dict_set_int(&encOpts, "packet_loss", options_.packetLoss, 0);
+        av_dict_set_int(&encOpts, "packet_size", options_.packetSize, 0);
+
+        if (avcodec_open2(encCtx, enc, &encOpts) < 0)
         {
+            av_dict_free(&encOpts);
             avcodec_free_context(&encCtx);
             swr_free(&swr);
             avcodec_free_context(&decCtx);
@@ -146,6 +280,7 @@ public:
             SetError("Failed to open encoder");
             return;
         }
+        av_dict_free(&encOpts);
 
         // 创建输出文件
         AVFormatContext *outFmt = nullptr;
@@ -216,6 +351,7 @@ public:
         AVPacket *pkt = av_packet_alloc();
         AVFrame *decFrame = av_frame_alloc();
         AVFrame *resampledFrame = av_frame_alloc();
+        AVPacket *outPkt = av_packet_alloc();
 
         // 编码器帧大小
         int frame_size = encCtx->frame_size > 0 ? encCtx->frame_size : 480;
@@ -223,149 +359,113 @@ public:
         // 重采样输出缓冲区(用于累积采样直到够一个编码帧)
         std::vector<int16_t> sample_buffer;
         int64_t next_pts = 0;
+        bool encode_failed = false; // 流水线中止 (编码线程写出失败或帧池出错) 或帧缓冲分配失败,停止解码
 
-        // 解码和重采样循环
-        int ret;
-        while ((ret = av_read_frame(inFmt, pkt)) >= 0)
+        // 流水线模式: SILK 编码和写出放到独立线程,本线程只做解复用/解码/重采样
+        std::unique_ptr<FrameQueue> frameQueue;
+        std::unique_ptr<EncodeThread> encodeThread;
+        if (options_.pipeline)
         {
-            if (pkt->stream_index != audioStream)
+            frameQueue.reset(new FrameQueue(8, AV_SAMPLE_FMT_S16, &encCtx->ch_layout, target_rate, frame_size));
+            if (frameQueue->Valid())
             {
-                av_packet_unref(pkt);
-                continue;
+                encodeThread.reset(new EncodeThread(encCtx, outFmt, outSt, *frameQueue));
+                encodeThread->Start();
             }
-
-            ret = avcodec_send_packet(decCtx, pkt);
-            av_packet_unref(pkt);
-            if (ret < 0)
-                continue;
-
-            while (avcodec_receive_frame(decCtx, decFrame) == 0)
+            else
             {
-                // 计算重采样后的采样数
-                int64_t delay = swr_get_delay(swr, decCtx->sample_rate);
-                int64_t out_count = av_rescale_rnd(delay + decFrame->nb_samples, target_rate, decCtx->sample_rate, AV_ROUND_UP);
-
-                // 分配重采样输出缓冲
-                uint8_t *resampled_data = nullptr;
-                int resampled_linesize = 0;
-                if (av_samples_alloc(&resampled_data, &resampled_linesize, 1, out_count, AV_SAMPLE_FMT_S16, 0) >= 0)
-                {
-                    // 执行重采样
-                    int converted_samples = swr_convert(swr, &resampled_data, out_count,
-                                                        (const uint8_t **)decFrame->data, decFrame->nb_samples);
-
-                    if (converted_samples > 0)
-                    {
-                        // 将重采样后的数据追加到缓冲区
-                        int16_t *samples = (int16_t *)resampled_data;
-                        sample_buffer.insert(sample_buffer.end(), samples, samples + converted_samples);
-                    }
-
-                    av_freep(&resampled_data);
-                }
-                av_frame_unref(decFrame);
-
-                // 当缓冲区有足够的采样时,送入编码器
-                while ((int)sample_buffer.size() >= frame_size)
-                {
-                    // 准备编码帧
-                    resampledFrame->nb_samples = frame_size;
-                    resampledFrame->format = AV_SAMPLE_FMT_S16;
-                    resampledFrame->sample_rate = target_rate;
-                    av_channel_layout_default(&resampledFrame->ch_layout, 1);
-                    av_frame_get_buffer(resampledFrame, 0);
-
-                    memcpy(resampledFrame->data[0], sample_buffer.data(), frame_size * sizeof(int16_t));
-                    resampledFrame->pts = next_pts;
-                    next_pts += frame_size;
-
-                    // 送入编码器
-                    ret = avcodec_send_frame(encCtx, resampledFrame);
-                    av_frame_unref(resampledFrame);
-
-                    if (ret == 0)
-                    {
-                        AVPacket *outPkt = av_packet_alloc();
-                        while (avcodec_receive_packet(encCtx, outPkt) == 0)
-                        {
-                            outPkt->stream_index = 0;
-                            av_packet_rescale_ts(outPkt, encCtx->time_base, outSt->time_base);
-                            av_interleaved_write_frame(outFmt, outPkt);
-                            av_packet_unref(outPkt);
-                        }
-                        av_packet_free(&outPkt);
-                    }
-
-                    // 从缓冲区移除已编码的采样
-                    sample_buffer.erase(sample_buffer.begin(), sample_buffer.begin() + frame_size);
-                }
+                frameQueue.reset(); // 分配失败时退回串行
             }
         }
 
-        // Flush 解码器
-        avcodec_send_packet(decCtx, nullptr);
-        while (avcodec_receive_frame(decCtx, decFrame) == 0)
+        // 取出编码器产生的所有数据包并写入输出
+        auto write_packets = [&]()
         {
-            int64_t delay = swr_get_delay(swr, decCtx->sample_rate);
-            int64_t out_count = av_rescale_rnd(delay + decFrame->nb_samples, target_rate, decCtx->sample_rate, AV_ROUND_UP);
-
-            uint8_t *resampled_data = nullptr;
-            int resampled_linesize = 0;
-            if (av_samples_alloc(&resampled_data, &resampled_linesize, 1, out_count, AV_SAMPLE_FMT_S16, 0) >= 0)
+            while (avcodec_receive_packet(encCtx, outPkt) == 0)
             {
-                int converted_samples = swr_convert(swr, &resampled_data, out_count,
-                                                    (const uint8_t **)decFrame->data, decFrame->nb_samples);
+                outPkt->stream_index = 0;
+                av_packet_rescale_ts(outPkt, encCtx->time_base, outSt->time_base);
+                av_interleaved_write_frame(outFmt, outPkt);
+                av_packet_unref(outPkt);
+            }
+        };
 
-                if (converted_samples > 0)
+        // 从缓冲区头部取 count 个采样编码一帧;失败时置 encode_failed 并返回 false,调用方必须退出循环
+        auto encode_samples = [&](int count) -> bool
+        {
+            AVFrame *frame = resampledFrame;
+            if (encodeThread)
+            {
+                frame = frameQueue->Acquire();
+                if (!frame)
                 {
-                    int16_t *samples = (int16_t *)resampled_data;
-                    sample_buffer.insert(sample_buffer.end(), samples, samples + converted_samples);
+                    encode_failed = true;
+                    return false;
                 }
-
-                av_freep(&resampled_data);
             }
-            av_frame_unref(decFrame);
-
-            while ((int)sample_buffer.size() >= frame_size)
+            else
             {
-                resampledFrame->nb_samples = frame_size;
                 resampledFrame->format = AV_SAMPLE_FMT_S16;
                 resampledFrame->sample_rate = target_rate;
                 av_channel_layout_default(&resampledFrame->ch_layout, 1);
-                av_frame_get_buffer(resampledFrame, 0);
-
-                memcpy(resampledFrame->data[0], sample_buffer.data(), frame_size * sizeof(int16_t));
-                resampledFrame->pts = next_pts;
-                next_pts += frame_size;
+                resampledFrame->nb_samples = count;
+                if (av_frame_get_buffer(resampledFrame, 0) < 0)
+                {
+                    encode_failed = true;
+                    return false;
+                }
+            }
+            frame->nb_samples = count;
+            memcpy(frame->data[0], sample_buffer.data(), count * sizeof(int16_t));
+            frame->pts = next_pts;
+            next_pts += count;
 
-                ret = avcodec_send_frame(encCtx, resampledFrame);
+            if (encodeThread)
+            {
+                frameQueue->Push(frame);
+            }
+            else
+            {
+                if (avcodec_send_frame(encCtx, resampledFrame) == 0)
+                    write_packets();
                 av_frame_unref(resampledFrame);
+            }
 
-                if (ret == 0)
+            // 从缓冲区移除已编码的采样
+            sample_buffer.erase(sample_buffer.begin(), sample_buffer.begin() + count);
+            return true;
+        };
+
+        // 解码帧重采样后追加到缓冲区,够一帧就送去编码;frame 为 nullptr 时冲刷重采样器
+        auto push_frame = [&](AVFrame *frame)
+        {
+            int in_samples = frame ? frame->nb_samples : 0;
+            if (convert)
+            {
+                if (!frame)
+                    return;
+                size_t used = sample_buffer.size();
+                sample_buffer.resize(used + in_samples);
+                uint8_t *dst[1] = {(uint8_t *)(sample_buffer.data() + used)};
+                convert(dst, (const uint8_t *const *)frame->data, in_samples, 1);
+                while ((int)sample_buffer.size() >= frame_size)
                 {
-                    AVPacket *outPkt = av_packet_alloc();
-                    while (avcodec_receive_packet(encCtx, outPkt) == 0)
-                    {
-                        outPkt->stream_index = 0;
-                        av_packet_rescale_ts(outPkt, encCtx->time_base, outSt->time_base);
-                        av_interleaved_write_frame(outFmt, outPkt);
-                        av_packet_unref(outPkt);
-                    }
-                    av_packet_free(&outPkt);
+                    if (!encode_samples(frame_size))
+                        break;
                 }
-
-                sample_buffer.erase(sample_buffer.begin(), sample_buffer.begin() + frame_size);
+                return;
             }
-        }
+            int64_t delay = swr_get_delay(swr, decCtx->sample_rate);
+            int64_t out_count = av_rescale_rnd(delay + in_samples, target_rate, decCtx->sample_rate, AV_ROUND_UP);
+            if (out_count <= 0)
+                return;
 
-        // Flush 重采样器
-        {
             uint8_t *resampled_data = nullptr;
             int resampled_linesize = 0;
-            int max_out_samples = frame_size * 2;
-            if (av_samples_alloc(&resampled_data, &resampled_linesize, 1, max_out_samples, AV_SAMPLE_FMT_S16, 0) >= 0)
+            if (av_samples_alloc(&resampled_data, &resampled_linesize, 1, out_count, AV_SAMPLE_FMT_S16, 0) >= 0)
             {
-                int converted_samples = swr_convert(swr, &resampled_data, max_out_samples, nullptr, 0);
+                int converted_samples = swr_convert(swr, &resampled_data, out_count,
+                                                    frame ? (const uint8_t **)frame->data : nullptr, in_samples);
                 if (converted_samples > 0)
                 {
                     int16_t *samples = (int16_t *)resampled_data;
@@ -373,56 +473,84 @@ public:
                 }
                 av_freep(&resampled_data);
             }
-        }
 
-        // 处理剩余的采样(包括不足一帧的部分)
-        while (!sample_buffer.empty())
-        {
-            int samples_to_encode = std::min((int)sample_buffer.size(), frame_size);
+            while ((int)sample_buffer.size() >= frame_size)
+            {
+                if (!encode_samples(frame_size))
+                    break;
+            }
+        };
 
-            resampledFrame->nb_samples = samples_to_encode;
-            resampledFrame->format = AV_SAMPLE_FMT_S16;
-            resampledFrame->sample_rate = target_rate;
-            av_channel_layout_default(&resampledFrame->ch_layout, 1);
-            av_frame_get_buffer(resampledFrame, 0);
+        // 只解码 [start, start + duration) 的窗口,越过结尾后不再读包
+        TimeWindow window(options_.start, options_.duration);
+        if (window.Active())
+            window.Seek(inFmt, audioStream);
 
-            memcpy(resampledFrame->data[0], sample_buffer.data(), samples_to_encode * sizeof(int16_t));
-            resampledFrame->pts = next_pts;
-            next_pts += samples_to_encode;
+        // 解码和重采样循环
+        while (!window.Done() && !encode_failed && av_read_frame(inFmt, pkt) >= 0)
+        {
+            if (pkt->stream_index != audioStream)
+            {
+                av_packet_unref(pkt);
+                continue;
+            }
 
-            ret = avcodec_send_frame(encCtx, resampledFrame);
-            av_frame_unref(resampledFrame);
+            int ret = avcodec_send_packet(decCtx, pkt);
+            av_packet_unref(pkt);
+            if (ret < 0)
+                continue;
 
-            if (ret == 0)
+            while (avcodec_receive_frame(decCtx, decFrame) == 0)
             {
-                AVPacket *outPkt = av_packet_alloc();
-                while (avcodec_receive_packet(encCtx, outPkt) == 0)
-                {
-                    outPkt->stream_index = 0;
-                    av_packet_rescale_ts(outPkt, encCtx->time_base, outSt->time_base);
-                    av_interleaved_write_frame(outFmt, outPkt);
-                    av_packet_unref(outPkt);
-                }
-                av_packet_free(&outPkt);
+                if (!window.Active() || window.Trim(decFrame))
+                    push_frame(decFrame);
+                av_frame_unref(decFrame);
             }
+        }
+
+        // Flush 解码器
+        avcodec_send_packet(decCtx, nullptr);
+        while (avcodec_receive_frame(decCtx, decFrame) == 0)
+        {
+            if (!window.Active() || window.Trim(decFrame))
+                push_frame(decFrame);
+            av_frame_unref(decFrame);
+        }
 
-            sample_buffer.erase(sample_buffer.begin(), sample_buffer.begin() + samples_to_encode);
+        // Flush 重采样器
+        push_frame(nullptr);
+
+        // 不足一包的尾部补静音,否则编码器会把它当作未完成的包丢弃
+        if (!sample_buffer.empty() && (int)sample_buffer.size() % frame_size != 0)
+        {
+            sample_buffer.resize(sample_buffer.size() + frame_size - sample_buffer.size() % frame_size, 0);
+        }
+
+        // 处理剩余的采样
+        while (!encode_failed && !sample_buffer.empty())
+        {
+            if (!encode_samples(std::min((int)sample_buffer.size(), frame_size)))
+                break;
         }
 
         // Flush 编码器
-        avcodec_send_frame(encCtx, nullptr);
-        AVPacket *outPkt = av_packet_alloc();
-        while (avcodec_receive_packet(encCtx, outPkt) == 0)
+        if (encodeThread)
         {
-            outPkt->stream_index = 0;
-            av_packet_rescale_ts(outPkt, encCtx->time_base, outSt->time_base);
-            av_interleaved_write_frame(outFmt, outPkt);
-            av_packet_unref(outPkt);
+            encodeThread->Finish();
+            encode_failed = encode_failed || encodeThread->Failed();
+            encodeThread.reset();
+            frameQueue.reset();
+        }
+        else if (!encode_failed)
+        {
+            avcodec_send_frame(encCtx, nullptr);
+            write_packets();
         }
         av_packet_free(&outPkt);
 
-        // 写入文件尾并清理
-        av_write_trailer(outFmt);
+        // 写入文件尾并清理;编码或写出失败时文件已不完整,不写文件尾
+        if (!encode_failed)
+            av_write_trailer(outFmt);
         if (!(outFmt->oformat->flags & AVFMT_NOFILE))
             avio_closep(&outFmt->pb);
 
@@ -434,11 +562,22 @@ public:
         avformat_free_context(outFmt);
         avcodec_free_context(&decCtx);
         avformat_close_input(&inFmt);
+
+        if (encode_failed)
+            SetError("Failed to encode or write output");
     }
 
     void OnOK() override
     {
-        deferred_.Resolve(Env().Undefined());
+        Napi::Env env = Env();
+        Object res = Object::New(env);
+        res.Set("success", Boolean::New(env, true));
+        res.Set("reencoded", Boolean::New(env, !copied_));
+        if (options_.segment > 0)
+            res.Set("segments", NewSegmentArray(env, segments_));
+        if (options_.trimSilence.enabled)
+            res.Set("trimmed", NewTrimmedObject(env, trimmedHead_, trimmedTail_));
+        deferred_.Resolve(res);
     }
 
     void OnError(const Error &e) override
@@ -447,12 +586,163 @@ public:
     }
 
 private:
+    // 分段 / 裁剪编码走通用编码分支,内部采样率按码率选择 (ratePolicy 'internal')
+    void ExecuteBranch()
+    {
+        OutputSpec spec;
+        spec.type = "silk";
+        spec.path = outPath_;
+        spec.bitrate = options_.bitrate;
+        spec.complexity = options_.complexity;
+        spec.packetSize = options_.packetSize;
+        spec.dtx = options_.dtx;
+        spec.fec = options_.fec;
+        spec.packetLoss = options_.packetLoss;
+        spec.resampleQuality = options_.resampleQuality;
+        spec.segment = options_.segment;
+        spec.trimSilence = options_.trimSilence;
+
+        MediaInput input;
+        input.path = inPath_;
+        AVFormatContext *fmt = nullptr;
+        AVCodecContext *dec = nullptr;
+        int stream = -1;
+        std::string error;
+        if (!OpenDecodeInput(input, nullptr, &fmt, &stream, &dec, error))
+        {
+            SetError(error);
+            return;
+        }
+
+        EncodeBranch branch(spec);
+        TimeWindow window(options_.start, options_.duration);
+        int decoded_rate = 0;
+        if (branch.Open(dec))
+            DecodeIntoBranch(fmt, stream, dec, branch, &window, decoded_rate);
+        branch.Finish();
+        avcodec_free_context(&dec);
+        CloseMediaInput(&fmt);
+        if (branch.Failed())
+        {
+            SetError(branch.Error());
+            return;
+        }
+        segments_ = branch.Segments();
+        trimmedHead_ = branch.TrimmedHead();
+        trimmedTail_ = branch.TrimmedTail();
+    }
+
+    // 只有显式给出的码率/包长才构成约束;其余编码参数对已编码的码流没有意义
+    bool CanCopySilk()
+    {
+        // 时间窗口需要按采样裁剪,只能解码后重新编码
+        if (options_.reencode || options_.start > 0 || options_.duration > 0)
+            return false;
+        if (!options_.bitrateSet && !options_.packetSizeSet)
+            return true;
+
+        SilkStreamStats stats;
+        if (!ScanSilkStream(inPath_, stats) || stats.corrupt || stats.frames == 0)
+            return false;
+        if (options_.bitrateSet)
+        {
+            int64_t bitrate = stats.bytes * 8 * 50 / stats.frames; // 每帧 20ms
+            if (bitrate > options_.bitrate || stats.maxRate > SilkInternalSampleRate(options_.bitrate))
+                return false;
+        }
+        if (options_.packetSizeSet && stats.framesPerPacket > 0 && stats.framesPerPacket * 20 != options_.packetSize)
+            return false;
+        return true;
+    }
+
+    // 流式复制: 写 TCT 文件头,数据包补回长度前缀后原样写出
+    void CopySilk(AVFormatContext *inFmt, int audioStream)
+    {
+        AVFormatContext *outFmt = nullptr;
+        if (avformat_alloc_output_context2(&outFmt, nullptr, "ntsilk_s16le", outPath_.c_str()) < 0 || !outFmt)
+        {
+            SetError("Failed to alloc output context");
+            return;
+        }
+        AVStream *outSt = avformat_new_stream(outFmt, nullptr);
+        if (!outSt || avcodec_parameters_copy(outSt->codecpar, inFmt->streams[audioStream]->codecpar) < 0)
+        {
+            avformat_free_context(outFmt);
+            SetError("Failed to create output stream");
+            return;
+        }
+        outSt->codecpar->codec_tag = 0;
+        outSt->time_base = inFmt->streams[audioStream]->time_base;
+
+        if (avio_open(&outFmt->pb, outPath_.c_str(), AVIO_FLAG_WRITE) < 0)
+        {
+            avformat_free_context(outFmt);
+            SetError("Failed to open output file");
+            return;
+        }
+        if (avformat_write_header(outFmt, nullptr) < 0)
+        {
+            avio_closep(&outFmt->pb);
+            avformat_free_context(outFmt);
+            SetError("Failed to write header");
+            return;
+        }
+
+        // 补长度前缀 (分配失败) 或写出失败时停止复制,文件已不完整,不写文件尾
+        AVPacket *pkt = av_packet_alloc();
+        AVPacket *outPkt = av_packet_alloc();
+        bool write_failed = !pkt || !outPkt;
+        while (!write_failed && av_read_frame(inFmt, pkt) >= 0)
+        {
+            if (pkt->stream_index == audioStream)
+            {
+                if (SilkPacketForMuxer(pkt, outPkt) < 0)
+                    write_failed = true;
+                else
+                {
+                    outPkt->stream_index = 0;
+                    if (av_write_frame(outFmt, outPkt) < 0)
+                        write_failed = true;
+                }
+            }
+            av_packet_unref(outPkt);
+            av_packet_unref(pkt);
+        }
+        av_packet_free(&outPkt);
+        av_packet_free(&pkt);
+
+        if (!write_failed && av_write_trailer(outFmt) < 0)
+            write_failed = true;
+        avio_closep(&outFmt->pb);
+        avformat_free_context(outFmt);
+        if (write_failed)
+        {
+            SetError("Failed to write output");
+            return;
+        }
+        copied_ = true;
+    }
+
     std::string inPath_;
     std::string outPath_;
+    SilkEncodeOptions options_;
     Promise::Deferred deferred_;
+    bool copied_;
+    std::vector<OutputSegment> segments_;
+    double trimmedHead_;
+    double trimmedTail_;
 };
 
-// convertToNTSilkTct(inputPath, outputPath) -> void
+// convertToNTSilkTct(inputPath, outputPath, options?) -> { success, reencoded }
+// options: { profile: 'default' | 'fast', complexity, bitrate, dtx, fec, packetLoss, packetSize, ratePolicy, reencode, pipeline, resampleQuality,
+//           start, duration, segment, trimSilence }
+// 'fast' 为批量转码用: complexity 0 + DTX;显式给出的字段覆盖 profile
+// ratePolicy: 'internal' (默认) 直接重采样到 SILK 内部采样率, 'nearest' 保持输入的最接近采样率
+// start / duration: 只编码这段时间窗口 (秒),输入为 SILK 时也会重新编码
+// segment: 按秒数切成多个文件 (如 60 秒语音上限),输出路径含 %d 时按它编号,否则为 name_000.ext 形式;总是重新编码
+// trimSilence: true 或 { threshold (dBFS,默认 -50), minDuration (秒,默认 0.3) },编码前裁掉首尾静音,
+//   结果中 trimmed 为 { head, tail } 秒数;总是重新编码
+// 输入已是 SILK (SKP 或 TCT) 时默认只改写文件头;显式的 bitrate / packetSize 不满足或 reencode 为 true 时才重新编码
 Value ConvertToNTSilkTct(const CallbackInfo &info)
 {
     Env env = info.Env();
@@ -464,8 +754,110 @@ Value ConvertToNTSilkTct(const CallbackInfo &info)
     std::string inPath = info[0].As<String>().Utf8Value();
     std::string outPath = info[1].As<String>().Utf8Value();
 
+    SilkEncodeOptions options;
+    if (info.Length() >= 3 && info[2].IsObject())
+    {
+        Object opts = info[2].As<Object>();
+        if (opts.Has("profile") && opts.Get("profile").IsString())
+        {
+            std::string profile = opts.Get("profile").As<String>().Utf8Value();
+            if (profile == "fast")
+            {
+                options.complexity = 0;
+                options.dtx = true;
+            }
+            else if (profile != "default")
+            {
+                TypeError::New(env, "Unsupported profile. Supported: default, fast").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+        }
+        if (opts.Has("complexity") && opts.Get("complexity").IsNumber())
+            options.complexity = opts.Get("complexity").As<Number>().Int32Value();
+        if (opts.Has("bitrate") && opts.Get("bitrate").IsNumber())
+        {
+            options.bitrate = opts.Get("bitrate").As<Number>().Int32Value();
+            options.bitrateSet = true;
+        }
+        if (opts.Has("dtx"))
+            options.dtx = opts.Get("dtx").ToBoolean().Value();
+        if (opts.Has("fec"))
+            options.fec = opts.Get("fec").ToBoolean().Value();
+        if (opts.Has("packetLoss") && opts.Get("packetLoss").IsNumber())
+            options.packetLoss = opts.Get("packetLoss").As<Number>().Int32Value();
+        if (opts.Has("packetSize") && opts.Get("packetSize").IsNumber())
+        {
+            options.packetSize = opts.Get("packetSize").As<Number>().Int32Value();
+            options.packetSizeSet = true;
+        }
+        if (opts.Has("reencode"))
+            options.reencode = opts.Get("reencode").ToBoolean().Value();
+        if (opts.Has("pipeline"))
+            options.pipeline = opts.Get("pipeline").ToBoolean().Value();
+        if (opts.Has("resampleQuality") && opts.Get("resampleQuality").IsString() &&
+            !ParseResampleQuality(opts.Get("resampleQuality").As<String>().Utf8Value(), options.resampleQuality))
+        {
+            TypeError::New(env, "resampleQuality must be 'fast', 'default' or 'high'").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (opts.Has("start") && opts.Get("start").IsNumber())
+            options.start = opts.Get("start").As<Number>().DoubleValue();
+        if (opts.Has("duration") && opts.Get("duration").IsNumber())
+            options.duration = opts.Get("duration").As<Number>().DoubleValue();
+        if (options.start < 0 || options.duration < 0)
+        {
+            TypeError::New(env, "start and duration must not be negative").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (opts.Has("segment") && opts.Get("segment").IsNumber())
+            options.segment = opts.Get("segment").As<Number>().DoubleValue();
+        if (options.segment < 0)
+        {
+            TypeError::New(env, "segment must not be negative").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (opts.Has("trimSilence") && !opts.Get("trimSilence").IsUndefined() &&
+            !ParseSilenceTrimOptions(env, opts.Get("trimSilence"), options.trimSilence))
+            return env.Null();
+        if (opts.Has("ratePolicy") && opts.Get("ratePolicy").IsString())
+        {
+            std::string ratePolicy = opts.Get("ratePolicy").As<String>().Utf8Value();
+            if (ratePolicy == "internal")
+                options.ratePolicy = SilkRatePolicy::Internal;
+            else if (ratePolicy == "nearest")
+                options.ratePolicy = SilkRatePolicy::Nearest;
+            else
+            {
+                TypeError::New(env, "Unsupported ratePolicy. Supported: internal, nearest").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+        }
+
+        // 编码器只接受 5000~60000 bps,超出时会被静默截断
+        if (options.bitrate < 5000 || options.bitrate > 60000)
+        {
+            TypeError::New(env, "bitrate must be between 5000 and 60000").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (options.complexity < 0 || options.complexity > 2)
+        {
+            TypeError::New(env, "complexity must be 0, 1 or 2").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (options.packetSize < 20 || options.packetSize > 100 || options.packetSize % 20 != 0)
+        {
+            TypeError::New(env, "packetSize must be 20, 40, 60, 80 or 100").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (options.packetLoss < 0 || options.packetLoss > 100)
+        {
+            TypeError::New(env, "packetLoss must be between 0 and 100").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
     Promise::Deferred deferred = Promise::Deferred::New(env);
-    ConvertToNTSilkTctWorker *worker = new ConvertToNTSilkTctWorker(inPath, outPath, deferred);
+    ConvertToNTSilkTctWorker *worker = new ConvertToNTSilkTctWorker(inPath, outPath, options, deferred);
     worker->Queue();
     return deferred.Promise();
 }
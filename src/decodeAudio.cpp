@@ -1,15 +1,14 @@
 #include "decodeAudio.h"
+#include "audioCommon.h"
+#include "encodeBranch.h"
+#include "framePipeline.h"
+#include "sampleConvert.h"
+#include "segmentEncode.h"
 #include <iostream>
 #include <map>
-
-// 格式配置结构
-struct FormatConfig
-{
-    const char *format_name;     // 容器格式
-    enum AVCodecID codec_id;     // 编码器ID
-    enum AVSampleFormat sample_fmt; // 采样格式
-    int bit_rate;                // 比特率
-};
+#include <memory>
+#include <algorithm>
+#include <cstring>
 
 // 支持的输出格式映射
 static const std::map<std::string, FormatConfig> FORMAT_CONFIGS = {
@@ -23,15 +22,34 @@ static const std::map<std::string, FormatConfig> FORMAT_CONFIGS = {
     {"flac", {"flac", AV_CODEC_ID_FLAC, AV_SAMPLE_FMT_S16, 0}}
 };
 
+const FormatConfig *FindFormatConfig(const std::string &name)
+{
+    auto it = FORMAT_CONFIGS.find(name);
+    return it != FORMAT_CONFIGS.end() ? &it->second : nullptr;
+}
+
+// 编码输出参数
+struct FmtEncodeOptions
+{
+    int sampleRate = 0;     // 0 表示自动选择最接近的采样率
+    bool pipeline = false;  // 解码和编码分别在两个线程上运行
+    int parallel = 0;       // 分段并行编码的段数,0/1 表示不分段
+    ResampleQuality resampleQuality = ResampleQuality::Default;
+    double start = 0;       // 起始时间(秒)
+    double duration = 0;    // 时长(秒),0 表示到结尾
+    double segment = 0;     // 分段时长(秒),0 表示输出单个文件
+    SilenceTrimOptions trimSilence; // 编码前裁掉首尾静音
+};
+
 // ===== DecodeAudioToFmt Async Worker =====
 class DecodeAudioToFmtWorker : public AsyncWorker
 {
 public:
-    DecodeAudioToFmtWorker(const std::string &inputPath, const std::string &outputPath, 
-                           const std::string &targetFormat, int targetSampleRate, Promise::Deferred deferred)
-        : AsyncWorker(deferred.Env()), inputPath_(inputPath), outputPath_(outputPath), 
-          targetFormat_(targetFormat), targetSampleRate_(targetSampleRate), 
-          deferred_(deferred), sampleRate_(0), channels_(0) {}
+    DecodeAudioToFmtWorker(const std::string &inputPath, const std::string &outputPath,
+                           const std::string &targetFormat, const FmtEncodeOptions &options, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), inputPath_(inputPath), outputPath_(outputPath),
+          targetFormat_(targetFormat), options_(options),
+          deferred_(deferred), sampleRate_(0), channels_(0), trimmedHead_(0), trimmedTail_(0) {}
 
     void Execute() override
     {
@@ -44,6 +62,14 @@ public:
         }
         const FormatConfig &config = it->second;
 
+        // 分段输出 / 静音裁剪走编码分支: 解码器和重采样器持续运行,
+        // 分段只在边界处轮换编码器和复用器,裁剪在重采样之后、编码之前进行
+        if (options_.segment > 0 || options_.trimSilence.enabled)
+        {
+            ExecuteBranch(config);
+            return;
+        }
+
         // 打开输入文件
         AVFormatContext *input_fmt_ctx = nullptr;
         if (avformat_open_input(&input_fmt_ctx, inputPath_.c_str(), nullptr, nullptr) != 0)
@@ -77,35 +103,11 @@ public:
 
         AVStream *input_stream = input_fmt_ctx->streams[audio_stream_index];
         
-        // 初始化解码器
-        const AVCodec *decoder = avcodec_find_decoder(input_stream->codecpar->codec_id);
-        if (!decoder)
-        {
-            avformat_close_input(&input_fmt_ctx);
-            SetError("Decoder not found");
-            return;
-        }
-        
-        AVCodecContext *decoder_ctx = avcodec_alloc_context3(decoder);
-        avcodec_parameters_to_context(decoder_ctx, input_stream->codecpar);
-        if (avcodec_open2(decoder_ctx, decoder, nullptr) < 0)
-        {
-            avcodec_free_context(&decoder_ctx);
-            avformat_close_input(&input_fmt_ctx);
-            SetError("Failed to open decoder");
-            return;
-        }
-
-        // 获取输入音频参数
-        int src_channels = input_stream->codecpar->ch_layout.nb_channels ? input_stream->codecpar->ch_layout.nb_channels : 1;
-        int src_sample_rate = input_stream->codecpar->sample_rate;
-        enum AVSampleFormat src_sample_fmt = (enum AVSampleFormat)input_stream->codecpar->format;
-
         // 确定输出采样率
         int out_sample_rate;
-        if (targetSampleRate_ > 0)
+        if (options_.sampleRate > 0)
         {
-            out_sample_rate = targetSampleRate_;
+            out_sample_rate = options_.sampleRate;
         }
         else
         {
@@ -115,11 +117,11 @@ public:
             
             // 找到最接近的采样率
             int closest_rate = supported_rates[0];
-            int min_diff = abs(src_sample_rate - supported_rates[0]);
+            int min_diff = abs(input_stream->codecpar->sample_rate - supported_rates[0]);
             
             for (int i = 1; i < num_rates; ++i)
             {
-                int diff = abs(src_sample_rate - supported_rates[i]);
+                int diff = abs(input_stream->codecpar->sample_rate - supported_rates[i]);
                 if (diff < min_diff)
                 {
                     min_diff = diff;
@@ -136,6 +138,39 @@ public:
             out_sample_rate = 8000;
         }
 
+        // 初始化解码器
+        const AVCodec *decoder = avcodec_find_decoder(input_stream->codecpar->codec_id);
+        if (!decoder)
+        {
+            avformat_close_input(&input_fmt_ctx);
+            SetError("Decoder not found");
+            return;
+        }
+        
+        // SILK 输入: 让解码器直接输出目标采样率,省去一次 swr 重采样
+        AVDictionary *decoder_opts = nullptr;
+        if (input_stream->codecpar->codec_id == AV_CODEC_ID_NTSILK_S16LE && IsSilkApiSampleRate(out_sample_rate))
+        {
+            av_dict_set_int(&decoder_opts, "api_sample_rate", out_sample_rate, 0);
+        }
+
+        AVCodecContext *decoder_ctx = avcodec_alloc_context3(decoder);
+        avcodec_parameters_to_context(decoder_ctx, input_stream->codecpar);
+        if (avcodec_open2(decoder_ctx, decoder, &decoder_opts) < 0)
+        {
+            av_dict_free(&decoder_opts);
+            avcodec_free_context(&decoder_ctx);
+            avformat_close_input(&input_fmt_ctx);
+            SetError("Failed to open decoder");
+            return;
+        }
+        av_dict_free(&decoder_opts);
+
+        // 获取解码器实际输出的音频参数
+        int src_channels = decoder_ctx->ch_layout.nb_channels ? decoder_ctx->ch_layout.nb_channels : 1;
+        int src_sample_rate = decoder_ctx->sample_rate;
+        enum AVSampleFormat src_sample_fmt = decoder_ctx->sample_fmt;
+
         // 设置输出声道布局(单声道)
         AVChannelLayout out_ch_layout = AV_CHANNEL_LAYOUT_MONO;
         int out_channels = 1;
@@ -256,10 +291,58 @@ public:
             return;
         }
 
+        // 分段并行编码: 只用于帧间独立的编码 (FLAC / PCM),输入不能分段或指定了时间窗口时继续走串行
+        if (options_.parallel > 1 && options_.start <= 0 && options_.duration <= 0 &&
+            (config.codec_id == AV_CODEC_ID_FLAC || config.codec_id == AV_CODEC_ID_PCM_S16LE))
+        {
+            SegmentEncodeOptions segment;
+            segment.inputPath = inputPath_;
+            segment.audioStream = audio_stream_index;
+            segment.segments = options_.parallel;
+            segment.resampleQuality = options_.resampleQuality;
+            segment.frameSize = encoder_ctx->frame_size > 0 ? encoder_ctx->frame_size : 1152;
+            segment.openEncoder = [&]() -> AVCodecContext *
+            {
+                AVCodecContext *ctx = avcodec_alloc_context3(encoder);
+                if (!ctx)
+                    return nullptr;
+                ctx->sample_rate = encoder_ctx->sample_rate;
+                ctx->sample_fmt = encoder_ctx->sample_fmt;
+                ctx->bit_rate = encoder_ctx->bit_rate;
+                ctx->compression_level = encoder_ctx->compression_level;
+                ctx->time_base = encoder_ctx->time_base;
+                if (av_channel_layout_copy(&ctx->ch_layout, &encoder_ctx->ch_layout) < 0 || avcodec_open2(ctx, encoder, nullptr) < 0)
+                    avcodec_free_context(&ctx);
+                return ctx;
+            };
+
+            std::string segment_error;
+            int segment_ret = EncodeSegmentsParallel(segment, encoder_ctx, output_fmt_ctx, output_stream, segment_error);
+            if (segment_ret != 0)
+            {
+                if (segment_ret > 0)
+                    av_write_trailer(output_fmt_ctx);
+                if (!(output_fmt_ctx->oformat->flags & AVFMT_NOFILE))
+                    avio_closep(&output_fmt_ctx->pb);
+                avformat_free_context(output_fmt_ctx);
+                avcodec_free_context(&encoder_ctx);
+                avcodec_free_context(&decoder_ctx);
+                avformat_close_input(&input_fmt_ctx);
+                if (segment_ret < 0)
+                {
+                    SetError(segment_error);
+                    return;
+                }
+                sampleRate_ = out_sample_rate;
+                channels_ = out_channels;
+                return;
+            }
+        }
+
         // 设置输入声道布局
         AVChannelLayout tmp_ch_layout;
         bool tmp_ch_layout_allocated = false;
-        const AVChannelLayout *in_ch_layout = &input_stream->codecpar->ch_layout;
+        const AVChannelLayout *in_ch_layout = &decoder_ctx->ch_layout;
         if (in_ch_layout->nb_channels == 0)
         {
             av_channel_layout_default(&tmp_ch_layout, src_channels);
@@ -267,39 +350,56 @@ public:
             tmp_ch_layout_allocated = true;
         }
 
+        // 解码输出已与编码器输入一致时(如 SILK 直接解码到目标采样率)跳过 swr
+        bool passthrough = src_sample_rate == out_sample_rate &&
+                           av_channel_layout_compare(in_ch_layout, &out_ch_layout) == 0 &&
+                           (src_sample_fmt == encoder_ctx->sample_fmt ||
+                            (out_channels == 1 && av_get_packed_sample_fmt(src_sample_fmt) == av_get_packed_sample_fmt(encoder_ctx->sample_fmt)));
+
+        // 只差采样格式/排列时(如单声道 f32 WAV 编码为 s16)用专用转换循环代替 swr
+        SampleConvertFn convert = nullptr;
+        if (!passthrough && IsFormatOnlyConversion(in_ch_layout, src_sample_rate, &out_ch_layout, out_sample_rate))
+        {
+            convert = FindSampleConverter(src_sample_fmt, encoder_ctx->sample_fmt);
+        }
+
         // 初始化重采样器 - 使用编码器实际的采样格式
         SwrContext *swr_ctx = nullptr;
-        if (swr_alloc_set_opts2(&swr_ctx,
-                                &out_ch_layout, encoder_ctx->sample_fmt, out_sample_rate,
-                                in_ch_layout, src_sample_fmt, src_sample_rate,
-                                0, nullptr) < 0 || !swr_ctx)
+        if (!passthrough && !convert)
         {
-            if (swr_ctx)
+            if (swr_alloc_set_opts2(&swr_ctx,
+                                    &out_ch_layout, encoder_ctx->sample_fmt, out_sample_rate,
+                                    in_ch_layout, src_sample_fmt, src_sample_rate,
+                                    0, nullptr) < 0 || !swr_ctx)
+            {
+                if (swr_ctx)
+                    swr_free(&swr_ctx);
+                if (tmp_ch_layout_allocated)
+                    av_channel_layout_uninit(&tmp_ch_layout);
+                if (!(output_fmt_ctx->oformat->flags & AVFMT_NOFILE))
+                    avio_closep(&output_fmt_ctx->pb);
+                avformat_free_context(output_fmt_ctx);
+                avcodec_free_context(&encoder_ctx);
+                avcodec_free_context(&decoder_ctx);
+                avformat_close_input(&input_fmt_ctx);
+                SetError("Failed to initialize resampler");
+                return;
+            }
+            ApplyResampleQuality(swr_ctx, options_.resampleQuality);
+            if (swr_init(swr_ctx) < 0)
+            {
                 swr_free(&swr_ctx);
-            if (tmp_ch_layout_allocated)
-                av_channel_layout_uninit(&tmp_ch_layout);
-            if (!(output_fmt_ctx->oformat->flags & AVFMT_NOFILE))
-                avio_closep(&output_fmt_ctx->pb);
-            avformat_free_context(output_fmt_ctx);
-            avcodec_free_context(&encoder_ctx);
-            avcodec_free_context(&decoder_ctx);
-            avformat_close_input(&input_fmt_ctx);
-            SetError("Failed to initialize resampler");
-            return;
-        }
-        if (swr_init(swr_ctx) < 0)
-        {
-            swr_free(&swr_ctx);
-            if (tmp_ch_layout_allocated)
-                av_channel_layout_uninit(&tmp_ch_layout);
-            if (!(output_fmt_ctx->oformat->flags & AVFMT_NOFILE))
-                avio_closep(&output_fmt_ctx->pb);
-            avformat_free_context(output_fmt_ctx);
-            avcodec_free_context(&encoder_ctx);
-            avcodec_free_context(&decoder_ctx);
-            avformat_close_input(&input_fmt_ctx);
-            SetError("Failed to initialize resampler");
-            return;
+                if (tmp_ch_layout_allocated)
+                    av_channel_layout_uninit(&tmp_ch_layout);
+                if (!(output_fmt_ctx->oformat->flags & AVFMT_NOFILE))
+                    avio_closep(&output_fmt_ctx->pb);
+                avformat_free_context(output_fmt_ctx);
+                avcodec_free_context(&encoder_ctx);
+                avcodec_free_context(&decoder_ctx);
+                avformat_close_input(&input_fmt_ctx);
+                SetError("Failed to initialize resampler");
+                return;
+            }
         }
 
         // 解码和编码
@@ -336,194 +436,257 @@ public:
             return;
         }
 
+        // WAV (PCM) 不需要编码: 转换后的采样直接作为数据包写出
+        // 可变帧长或没有帧长限制的编码器: 每次转换的结果整块送入编码器
+        // 这两种情况都不经过 FIFO 分帧,也不需要流水线
+        bool bypass_encoder = config.codec_id == AV_CODEC_ID_PCM_S16LE;
+        bool direct_output = bypass_encoder || encoder_ctx->frame_size == 0 ||
+                             (encoder->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE);
+
+        // 流水线模式: 编码和写出放到独立线程,本线程只做解复用/解码/重采样
+        // 两段之间通过固定大小的帧池交换数据,内存占用有上限
+        std::unique_ptr<FrameQueue> frame_queue;
+        std::unique_ptr<EncodeThread> encode_thread;
+        if (options_.pipeline && !direct_output)
+        {
+            frame_queue.reset(new FrameQueue(8, encoder_ctx->sample_fmt, &out_ch_layout, out_sample_rate, frame_size));
+            if (frame_queue->Valid())
+            {
+                encode_thread.reset(new EncodeThread(encoder_ctx, output_fmt_ctx, output_stream, *frame_queue));
+                encode_thread->Start();
+            }
+            else
+            {
+                frame_queue.reset(); // 分配失败时退回串行
+            }
+        }
+
         int64_t pts = 0;
+        bool encode_failed = false; // 流水线中止 (编码线程写出失败或帧池出错),停止解码
 
-        while (av_read_frame(input_fmt_ctx, input_packet) >= 0)
+        // 取出编码器产生的所有数据包并写入输出
+        auto write_packets = [&]()
         {
-            if (input_packet->stream_index == audio_stream_index)
+            while (avcodec_receive_packet(encoder_ctx, output_packet) == 0)
             {
-                if (avcodec_send_packet(decoder_ctx, input_packet) == 0)
+                output_packet->stream_index = 0;
+                av_packet_rescale_ts(output_packet, encoder_ctx->time_base, output_stream->time_base);
+                av_interleaved_write_frame(output_fmt_ctx, output_packet);
+                av_packet_unref(output_packet);
+            }
+        };
+
+        // 从FIFO按编码器帧大小取样本编码; flush 时连不足一帧的尾部一起编码
+        auto encode_fifo = [&](bool flush)
+        {
+            while (av_audio_fifo_size(fifo) >= frame_size || (flush && av_audio_fifo_size(fifo) > 0))
+            {
+                int nb_samples = std::min(av_audio_fifo_size(fifo), frame_size);
+                if (encode_thread)
                 {
-                    while (avcodec_receive_frame(decoder_ctx, decoded_frame) == 0)
+                    AVFrame *pooled_frame = frame_queue->Acquire();
+                    if (!pooled_frame)
                     {
-                        // 计算重采样后的样本数
-                        int dst_nb_samples = av_rescale_rnd(
-                            swr_get_delay(swr_ctx, src_sample_rate) + decoded_frame->nb_samples,
-                            out_sample_rate, src_sample_rate, AV_ROUND_UP);
-
-                        // 分配重采样帧
-                        resampled_frame->format = encoder_ctx->sample_fmt;
-                        resampled_frame->ch_layout = out_ch_layout;
-                        resampled_frame->sample_rate = out_sample_rate;
-                        resampled_frame->nb_samples = dst_nb_samples;
-
-                        if (av_frame_get_buffer(resampled_frame, 0) < 0)
-                        {
-                            continue;
-                        }
-
-                        // 执行重采样
-                        int converted_samples = swr_convert(swr_ctx,
-                                                           resampled_frame->data, dst_nb_samples,
-                                                           (const uint8_t **)decoded_frame->data, decoded_frame->nb_samples);
-
-                        if (converted_samples > 0)
-                        {
-                            // 将重采样的数据写入FIFO
-                            av_audio_fifo_write(fifo, (void **)resampled_frame->data, converted_samples);
-
-                            // 当FIFO中有足够的样本时,编码帧
-                            while (av_audio_fifo_size(fifo) >= frame_size)
-                            {
-                                AVFrame *encode_frame = av_frame_alloc();
-                                encode_frame->format = encoder_ctx->sample_fmt;
-                                encode_frame->ch_layout = out_ch_layout;
-                                encode_frame->sample_rate = out_sample_rate;
-                                encode_frame->nb_samples = frame_size;
-
-                                if (av_frame_get_buffer(encode_frame, 0) >= 0)
-                                {
-                                    av_audio_fifo_read(fifo, (void **)encode_frame->data, frame_size);
-                                    encode_frame->pts = pts;
-                                    pts += frame_size;
-
-                                    if (avcodec_send_frame(encoder_ctx, encode_frame) == 0)
-                                    {
-                                        while (avcodec_receive_packet(encoder_ctx, output_packet) == 0)
-                                        {
-                                            output_packet->stream_index = 0;
-                                            av_packet_rescale_ts(output_packet, encoder_ctx->time_base, output_stream->time_base);
-                                            av_interleaved_write_frame(output_fmt_ctx, output_packet);
-                                            av_packet_unref(output_packet);
-                                        }
-                                    }
-                                }
-                                av_frame_free(&encode_frame);
-                            }
-                        }
-
-                        av_frame_unref(resampled_frame);
+                        encode_failed = true;
+                        break;
                     }
+                    pooled_frame->nb_samples = nb_samples;
+                    av_audio_fifo_read(fifo, (void **)pooled_frame->data, nb_samples);
+                    pooled_frame->pts = pts;
+                    pts += nb_samples;
+                    frame_queue->Push(pooled_frame);
+                    continue;
                 }
+
+                AVFrame *encode_frame = av_frame_alloc();
+                encode_frame->format = encoder_ctx->sample_fmt;
+                encode_frame->ch_layout = out_ch_layout;
+                encode_frame->sample_rate = out_sample_rate;
+                encode_frame->nb_samples = nb_samples;
+
+                if (av_frame_get_buffer(encode_frame, 0) < 0)
+                {
+                    av_frame_free(&encode_frame);
+                    break;
+                }
+                av_audio_fifo_read(fifo, (void **)encode_frame->data, nb_samples);
+                encode_frame->pts = pts;
+                pts += nb_samples;
+
+                if (avcodec_send_frame(encoder_ctx, encode_frame) == 0)
+                {
+                    write_packets();
+                }
+                av_frame_free(&encode_frame);
             }
-            av_packet_unref(input_packet);
-        }
+        };
 
-        // 刷新解码器
-        avcodec_send_packet(decoder_ctx, nullptr);
-        while (avcodec_receive_frame(decoder_ctx, decoded_frame) == 0)
+        std::vector<uint8_t> convert_out;
+
+        // 转换后的采样: 直接输出时立即写出或编码,否则写入FIFO等待分帧
+        auto write_samples = [&](void **data, int nb_samples)
         {
+            if (nb_samples <= 0)
+                return;
+            if (!direct_output)
+            {
+                av_audio_fifo_write(fifo, data, nb_samples);
+                return;
+            }
+
+            if (bypass_encoder)
+            {
+                // 输出固定为单声道,只有一个平面
+                int bytes = nb_samples * av_get_bytes_per_sample(encoder_ctx->sample_fmt);
+                if (av_new_packet(output_packet, bytes) < 0)
+                    return;
+                memcpy(output_packet->data, data[0], bytes);
+                output_packet->pts = pts;
+                output_packet->dts = pts;
+                output_packet->duration = nb_samples;
+                output_packet->flags |= AV_PKT_FLAG_KEY;
+                output_packet->stream_index = 0;
+                pts += nb_samples;
+                av_packet_rescale_ts(output_packet, encoder_ctx->time_base, output_stream->time_base);
+                av_interleaved_write_frame(output_fmt_ctx, output_packet);
+                av_packet_unref(output_packet);
+                return;
+            }
+
+            AVFrame *encode_frame = av_frame_alloc();
+            encode_frame->format = encoder_ctx->sample_fmt;
+            encode_frame->ch_layout = out_ch_layout;
+            encode_frame->sample_rate = out_sample_rate;
+            encode_frame->nb_samples = nb_samples;
+            if (av_frame_get_buffer(encode_frame, 0) < 0)
+            {
+                av_frame_free(&encode_frame);
+                return;
+            }
+            av_samples_copy(encode_frame->data, (uint8_t *const *)data, 0, 0, nb_samples, out_channels, encoder_ctx->sample_fmt);
+            encode_frame->pts = pts;
+            pts += nb_samples;
+            if (avcodec_send_frame(encoder_ctx, encode_frame) == 0)
+            {
+                write_packets();
+            }
+            av_frame_free(&encode_frame);
+        };
+
+        // 解码帧经重采样后输出; frame 为 nullptr 时冲刷重采样器
+        auto push_frame = [&](AVFrame *frame)
+        {
+            if (convert)
+            {
+                // 输出固定为单声道,只有一个平面
+                if (!frame)
+                    return;
+                convert_out.resize((size_t)frame->nb_samples * av_get_bytes_per_sample(encoder_ctx->sample_fmt));
+                uint8_t *dst[1] = {convert_out.data()};
+                convert(dst, (const uint8_t *const *)frame->data, frame->nb_samples, out_channels);
+                void *planes[1] = {convert_out.data()};
+                write_samples(planes, frame->nb_samples);
+                return;
+            }
+            if (!swr_ctx)
+            {
+                // 解码输出已是编码器输入格式,不用转换
+                if (frame)
+                    write_samples((void **)frame->data, frame->nb_samples);
+                return;
+            }
+
+            int in_samples = frame ? frame->nb_samples : 0;
             int dst_nb_samples = av_rescale_rnd(
-                swr_get_delay(swr_ctx, src_sample_rate) + decoded_frame->nb_samples,
+                swr_get_delay(swr_ctx, src_sample_rate) + in_samples,
                 out_sample_rate, src_sample_rate, AV_ROUND_UP);
+            if (dst_nb_samples <= 0)
+                return;
 
             resampled_frame->format = encoder_ctx->sample_fmt;
             resampled_frame->ch_layout = out_ch_layout;
             resampled_frame->sample_rate = out_sample_rate;
             resampled_frame->nb_samples = dst_nb_samples;
+            if (av_frame_get_buffer(resampled_frame, 0) < 0)
+                return;
 
-            if (av_frame_get_buffer(resampled_frame, 0) >= 0)
+            int converted_samples = swr_convert(swr_ctx,
+                                                resampled_frame->data, dst_nb_samples,
+                                                frame ? (const uint8_t **)frame->data : nullptr, in_samples);
+            if (converted_samples > 0)
             {
-                int converted_samples = swr_convert(swr_ctx,
-                                                   resampled_frame->data, dst_nb_samples,
-                                                   (const uint8_t **)decoded_frame->data, decoded_frame->nb_samples);
-
-                if (converted_samples > 0)
-                {
-                    av_audio_fifo_write(fifo, (void **)resampled_frame->data, converted_samples);
-
-                    while (av_audio_fifo_size(fifo) >= frame_size)
-                    {
-                        AVFrame *encode_frame = av_frame_alloc();
-                        encode_frame->format = encoder_ctx->sample_fmt;
-                        encode_frame->ch_layout = out_ch_layout;
-                        encode_frame->sample_rate = out_sample_rate;
-                        encode_frame->nb_samples = frame_size;
-
-                        if (av_frame_get_buffer(encode_frame, 0) >= 0)
-                        {
-                            av_audio_fifo_read(fifo, (void **)encode_frame->data, frame_size);
-                            encode_frame->pts = pts;
-                            pts += frame_size;
-
-                            if (avcodec_send_frame(encoder_ctx, encode_frame) == 0)
-                            {
-                                while (avcodec_receive_packet(encoder_ctx, output_packet) == 0)
-                                {
-                                    output_packet->stream_index = 0;
-                                    av_packet_rescale_ts(output_packet, encoder_ctx->time_base, output_stream->time_base);
-                                    av_interleaved_write_frame(output_fmt_ctx, output_packet);
-                                    av_packet_unref(output_packet);
-                                }
-                            }
-                        }
-                        av_frame_free(&encode_frame);
-                    }
-                }
+                write_samples((void **)resampled_frame->data, converted_samples);
             }
             av_frame_unref(resampled_frame);
-        }
+        };
 
-        // 刷新重采样器中剩余的样本
-        int converted_samples = swr_convert(swr_ctx, resampled_frame->data, frame_size, nullptr, 0);
-        if (converted_samples > 0)
-        {
-            av_audio_fifo_write(fifo, (void **)resampled_frame->data, converted_samples);
-        }
+        // 只解码 [start, start + duration) 的窗口,越过结尾后不再读包
+        TimeWindow window(options_.start, options_.duration);
+        if (window.Active())
+            window.Seek(input_fmt_ctx, audio_stream_index);
 
-        // 处理FIFO中剩余的样本
-        while (av_audio_fifo_size(fifo) > 0)
+        while (!window.Done() && !encode_failed && av_read_frame(input_fmt_ctx, input_packet) >= 0)
         {
-            int remaining = av_audio_fifo_size(fifo);
-            AVFrame *encode_frame = av_frame_alloc();
-            encode_frame->format = encoder_ctx->sample_fmt;
-            encode_frame->ch_layout = out_ch_layout;
-            encode_frame->sample_rate = out_sample_rate;
-            encode_frame->nb_samples = remaining;
-
-            if (av_frame_get_buffer(encode_frame, 0) >= 0)
+            if (input_packet->stream_index == audio_stream_index)
             {
-                av_audio_fifo_read(fifo, (void **)encode_frame->data, remaining);
-                encode_frame->pts = pts;
-                pts += remaining;
-
-                if (avcodec_send_frame(encoder_ctx, encode_frame) == 0)
+                if (avcodec_send_packet(decoder_ctx, input_packet) == 0)
                 {
-                    while (avcodec_receive_packet(encoder_ctx, output_packet) == 0)
+                    while (avcodec_receive_frame(decoder_ctx, decoded_frame) == 0)
                     {
-                        output_packet->stream_index = 0;
-                        av_packet_rescale_ts(output_packet, encoder_ctx->time_base, output_stream->time_base);
-                        av_interleaved_write_frame(output_fmt_ctx, output_packet);
-                        av_packet_unref(output_packet);
+                        if (window.Active() && !window.Trim(decoded_frame))
+                            continue;
+                        push_frame(decoded_frame);
+                        encode_fifo(false);
                     }
                 }
             }
-            av_frame_free(&encode_frame);
-            break;
+            av_packet_unref(input_packet);
         }
 
+        // 刷新解码器
+        avcodec_send_packet(decoder_ctx, nullptr);
+        while (avcodec_receive_frame(decoder_ctx, decoded_frame) == 0)
+        {
+            if (window.Active() && !window.Trim(decoded_frame))
+                continue;
+            push_frame(decoded_frame);
+            encode_fifo(false);
+        }
+
+        // 刷新重采样器中剩余的样本
+        push_frame(nullptr);
+
+        // 处理FIFO中剩余的样本
+        encode_fifo(true);
+
         // 刷新编码器
-        avcodec_send_frame(encoder_ctx, nullptr);
-        while (avcodec_receive_packet(encoder_ctx, output_packet) == 0)
+        if (encode_thread)
         {
-            output_packet->stream_index = 0;
-            av_packet_rescale_ts(output_packet, encoder_ctx->time_base, output_stream->time_base);
-            av_interleaved_write_frame(output_fmt_ctx, output_packet);
-            av_packet_unref(output_packet);
+            encode_thread->Finish();
+            encode_failed = encode_failed || encode_thread->Failed();
+            encode_thread.reset();
+            frame_queue.reset();
+        }
+        else
+        {
+            avcodec_send_frame(encoder_ctx, nullptr);
+            write_packets();
         }
 
         // 清理FIFO
         av_audio_fifo_free(fifo);
 
-        // 写入文件尾
-        av_write_trailer(output_fmt_ctx);
+        // 写入文件尾;编码或写出失败时文件已不完整,不写文件尾
+        if (!encode_failed)
+            av_write_trailer(output_fmt_ctx);
 
         // 清理资源
         av_packet_free(&output_packet);
         av_frame_free(&resampled_frame);
         av_frame_free(&decoded_frame);
         av_packet_free(&input_packet);
-        swr_free(&swr_ctx);
+        if (swr_ctx)
+            swr_free(&swr_ctx);
         if (tmp_ch_layout_allocated)
             av_channel_layout_uninit(&tmp_ch_layout);
         
@@ -534,6 +697,11 @@ public:
         avcodec_free_context(&decoder_ctx);
         avformat_close_input(&input_fmt_ctx);
 
+        if (encode_failed)
+        {
+            SetError("Failed to encode or write output");
+            return;
+        }
         sampleRate_ = out_sample_rate;
         channels_ = out_channels;
     }
@@ -546,6 +714,10 @@ public:
         res.Set("sampleRate", Number::New(env, sampleRate_));
         res.Set("channels", Number::New(env, channels_));
         res.Set("format", String::New(env, targetFormat_));
+        if (options_.segment > 0)
+            res.Set("segments", NewSegmentArray(env, segments_));
+        if (options_.trimSilence.enabled)
+            res.Set("trimmed", NewTrimmedObject(env, trimmedHead_, trimmedTail_));
         deferred_.Resolve(res);
     }
 
@@ -555,13 +727,59 @@ public:
     }
 
 private:
+    void ExecuteBranch(const FormatConfig &config)
+    {
+        OutputSpec spec;
+        spec.type = "audio";
+        spec.path = outputPath_;
+        spec.format = &config;
+        spec.sampleRate = options_.sampleRate;
+        spec.resampleQuality = options_.resampleQuality;
+        spec.segment = options_.segment;
+        spec.trimSilence = options_.trimSilence;
+
+        MediaInput input;
+        input.path = inputPath_;
+        AVFormatContext *fmt = nullptr;
+        AVCodecContext *dec = nullptr;
+        int stream = -1;
+        std::string error;
+        if (!OpenDecodeInput(input, nullptr, &fmt, &stream, &dec, error))
+        {
+            SetError(error);
+            return;
+        }
+
+        EncodeBranch branch(spec);
+        TimeWindow window(options_.start, options_.duration);
+        int decoded_rate = 0;
+        if (branch.Open(dec))
+            DecodeIntoBranch(fmt, stream, dec, branch, &window, decoded_rate);
+        branch.Finish();
+        avcodec_free_context(&dec);
+        CloseMediaInput(&fmt);
+        if (branch.Failed())
+        {
+            SetError(branch.Error());
+            return;
+        }
+        sampleRate_ = branch.SampleRate();
+        channels_ = 1;
+        segments_ = branch.Segments();
+        trimmedHead_ = branch.TrimmedHead();
+        trimmedTail_ = branch.TrimmedTail();
+    }
+
     std::string inputPath_;
     std::string outputPath_;
     std::string targetFormat_;
-    int targetSampleRate_;
+    FmtEncodeOptions options_;
     Promise::Deferred deferred_;
     int sampleRate_;
     int channels_;
+    std::vector<OutputSegment> segments_;
+    double trimmedHead_;
+    double trimmedTail_;
 };
 
 Value DecodeAudioToFmt(const CallbackInfo &info)
@@ -577,15 +795,56 @@ Value DecodeAudioToFmt(const CallbackInfo &info)
     std::string outputPath = info[1].As<String>().Utf8Value();
     std::string targetFormat = info[2].As<String>().Utf8Value();
     
-    // 第四个参数可选:目标采样率
-    int targetSampleRate = 0; // 0 表示自动选择最接近的采样率
+    // 第四个参数可选:目标采样率,或 { sampleRate, pipeline, parallel, resampleQuality, start, duration, segment, trimSilence }
+    // pipeline 为 true 时解码和编码分别在两个线程上运行
+    // parallel 为分段数: wav / flac 输出时把输入切成若干段并行编码再拼接 (输入需可 seek、每段至少 30 秒、采样率与输出相同)
+    // start / duration 单位为秒: 只解码并编码这段窗口
+    // segment 单位为秒: 按采样精确切成多个文件,输出路径含 %d 时按它编号,否则为 name_000.ext 形式
+    // trimSilence: true 或 { threshold (dBFS,默认 -50), minDuration (秒,默认 0.3) },编码前裁掉首尾静音,
+    // 结果中 trimmed 为 { head, tail } 秒数
+    FmtEncodeOptions options;
     if (info.Length() >= 4 && info[3].IsNumber())
     {
-        targetSampleRate = info[3].As<Number>().Int32Value();
+        options.sampleRate = info[3].As<Number>().Int32Value();
+    }
+    else if (info.Length() >= 4 && info[3].IsObject())
+    {
+        Object opts = info[3].As<Object>();
+        if (opts.Has("sampleRate") && opts.Get("sampleRate").IsNumber())
+            options.sampleRate = opts.Get("sampleRate").As<Number>().Int32Value();
+        if (opts.Has("pipeline"))
+            options.pipeline = opts.Get("pipeline").ToBoolean().Value();
+        if (opts.Has("parallel") && opts.Get("parallel").IsNumber())
+            options.parallel = opts.Get("parallel").As<Number>().Int32Value();
+        if (opts.Has("resampleQuality") && opts.Get("resampleQuality").IsString() &&
+            !ParseResampleQuality(opts.Get("resampleQuality").As<String>().Utf8Value(), options.resampleQuality))
+        {
+            TypeError::New(env, "resampleQuality must be 'fast', 'default' or 'high'").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (opts.Has("start") && opts.Get("start").IsNumber())
+            options.start = opts.Get("start").As<Number>().DoubleValue();
+        if (opts.Has("duration") && opts.Get("duration").IsNumber())
+            options.duration = opts.Get("duration").As<Number>().DoubleValue();
+        if (options.start < 0 || options.duration < 0)
+        {
+            TypeError::New(env, "start and duration must not be negative").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (opts.Has("segment") && opts.Get("segment").IsNumber())
+            options.segment = opts.Get("segment").As<Number>().DoubleValue();
+        if (options.segment < 0)
+        {
+            TypeError::New(env, "segment must not be negative").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (opts.Has("trimSilence") && !opts.Get("trimSilence").IsUndefined() &&
+            !ParseSilenceTrimOptions(env, opts.Get("trimSilence"), options.trimSilence))
+            return env.Null();
     }
     
     Promise::Deferred deferred = Promise::Deferred::New(env);
-    DecodeAudioToFmtWorker *worker = new DecodeAudioToFmtWorker(inputPath, outputPath, targetFormat, targetSampleRate, deferred);
+    DecodeAudioToFmtWorker *worker = new DecodeAudioToFmtWorker(inputPath, outputPath, targetFormat, options, deferred);
     worker->Queue();
     return deferred.Promise();
 }
@@ -2,5 +2,17 @@
 
 #include "ffmpegCommon.h"
 
+// 格式配置结构
+struct FormatConfig
+{
+    const char *format_name;     // 容器格式
+    enum AVCodecID codec_id;     // 编码器ID
+    enum AVSampleFormat sample_fmt; // 采样格式
+    int bit_rate;                // 比特率
+};
+
+// 按输出格式名 (mp3 / amr / wma / m4a / spx / ogg / wav / flac) 查找配置,不支持时返回 nullptr
+const FormatConfig *FindFormatConfig(const std::string &name);
+
 // Forward declaration
 Value DecodeAudioToFmt(const CallbackInfo &info);
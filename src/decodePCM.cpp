@@ -1,22 +1,59 @@
 #include "decodeAudio.h"
+#include "audioCommon.h"
+#include "sampleConvert.h"
+#include "encodeBranch.h"
+#include <algorithm>
 #include <iostream>
 
+// PCM 输出参数
+struct PcmOutputOptions
+{
+    int sampleRate = 0;                               // 0 表示自动选择最接近的采样率
+    enum AVSampleFormat sampleFormat = AV_SAMPLE_FMT_S16; // 已包含平面/交错信息
+    std::string channelLayout;                        // 例如 "mono" / "stereo",优先于 channels
+    int channels = 1;                                 // 默认单声道
+    ResampleQuality resampleQuality = ResampleQuality::Default;
+    double start = 0;                                 // 起始时间(秒)
+    double duration = 0;                              // 时长(秒),0 表示到结尾
+    double segment = 0;                               // 分段时长(秒),0 表示不分段
+};
+
 // ===== DecodeAudioToPCM Async Worker =====
 class DecodeAudioToPCMWorker : public AsyncWorker
 {
 public:
-    DecodeAudioToPCMWorker(const std::string &inputPath, const std::string &outputPath, int targetSampleRate, Promise::Deferred deferred)
-        : AsyncWorker(deferred.Env()), inputPath_(inputPath), outputPath_(outputPath), targetSampleRate_(targetSampleRate), deferred_(deferred), sampleRate_(0), channels_(0) {}
+    DecodeAudioToPCMWorker(const std::string &inputPath, const std::string &outputPath, const PcmOutputOptions &options, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), inputPath_(inputPath), outputPath_(outputPath), options_(options), deferred_(deferred), sampleRate_(0), channels_(0) {}
 
     void Execute() override
     {
+        // 确定输出声道布局
+        AVChannelLayout out_ch_layout;
+        if (!options_.channelLayout.empty())
+        {
+            if (av_channel_layout_from_string(&out_ch_layout, options_.channelLayout.c_str()) < 0)
+            {
+                SetError("Invalid channel layout");
+                return;
+            }
+        }
+        else
+        {
+            av_channel_layout_default(&out_ch_layout, options_.channels);
+        }
+        int out_channels = out_ch_layout.nb_channels;
+        enum AVSampleFormat out_sample_fmt = options_.sampleFormat;
+        bool planar = av_sample_fmt_is_planar(out_sample_fmt);
+        int bytes_per_sample = av_get_bytes_per_sample(out_sample_fmt);
+
         // 打开输出文件
         FILE *outFile = nullptr;
         if (!outputPath_.empty())
         {
-            outFile = fopen(outputPath_.c_str(), "wb");
+            outFile = fopen(options_.segment > 0 ? SegmentOutputPath(outputPath_, 0).c_str() : outputPath_.c_str(), "wb");
             if (!outFile)
             {
+                av_channel_layout_uninit(&out_ch_layout);
                 SetError("Failed to open output file");
                 return;
             }
@@ -27,12 +64,16 @@ public:
         {
             if (outFile)
                 fclose(outFile);
+            av_channel_layout_uninit(&out_ch_layout);
             SetError("Failed to open input");
             return;
         }
         if (avformat_find_stream_info(fmt, nullptr) < 0)
         {
             avformat_close_input(&fmt);
+            if (outFile)
+                fclose(outFile);
+            av_channel_layout_uninit(&out_ch_layout);
             SetError("Failed to find stream info");
             return;
         }
@@ -48,6 +89,9 @@ public:
         if (audStream < 0)
         {
             avformat_close_input(&fmt);
+            if (outFile)
+                fclose(outFile);
+            av_channel_layout_uninit(&out_ch_layout);
             SetError("No audio stream");
             return;
         }
@@ -56,28 +100,18 @@ public:
         if (!dec)
         {
             avformat_close_input(&fmt);
+            if (outFile)
+                fclose(outFile);
+            av_channel_layout_uninit(&out_ch_layout);
             SetError("Decoder not found");
             return;
         }
-        AVCodecContext *c = avcodec_alloc_context3(dec);
-        avcodec_parameters_to_context(c, st->codecpar);
-        if (avcodec_open2(c, dec, nullptr) < 0)
-        {
-            avcodec_free_context(&c);
-            avformat_close_input(&fmt);
-            SetError("Failed to open codec");
-            return;
-        }
-
-        int src_channels = st->codecpar->ch_layout.nb_channels ? st->codecpar->ch_layout.nb_channels : 1;
-        int src_sample_rate = st->codecpar->sample_rate;
-        enum AVSampleFormat src_sample_fmt = (enum AVSampleFormat)st->codecpar->format;
 
         // 如果指定了目标采样率,使用它;否则自动选择最接近的采样率
         int out_sample_rate;
-        if (targetSampleRate_ > 0)
+        if (options_.sampleRate > 0)
         {
-            out_sample_rate = targetSampleRate_;
+            out_sample_rate = options_.sampleRate;
         }
         else
         {
@@ -87,11 +121,11 @@ public:
             
             // 找到最接近的采样率
             int closest_rate = supported_rates[0];
-            int min_diff = abs(src_sample_rate - supported_rates[0]);
+            int min_diff = abs(st->codecpar->sample_rate - supported_rates[0]);
             
             for (int i = 1; i < num_rates; ++i)
             {
-                int diff = abs(src_sample_rate - supported_rates[i]);
+                int diff = abs(st->codecpar->sample_rate - supported_rates[i]);
                 if (diff < min_diff)
                 {
                     min_diff = diff;
@@ -102,43 +136,201 @@ public:
             out_sample_rate = closest_rate;
         }
 
+        // SILK 输入: 让解码器直接输出目标采样率,省去一次 swr 重采样
+        AVDictionary *dec_opts = nullptr;
+        if (st->codecpar->codec_id == AV_CODEC_ID_NTSILK_S16LE && IsSilkApiSampleRate(out_sample_rate))
+        {
+            av_dict_set_int(&dec_opts, "api_sample_rate", out_sample_rate, 0);
+        }
+
+        AVCodecContext *c = avcodec_alloc_context3(dec);
+        avcodec_parameters_to_context(c, st->codecpar);
+        if (avcodec_open2(c, dec, &dec_opts) < 0)
+        {
+            av_dict_free(&dec_opts);
+            avcodec_free_context(&c);
+            avformat_close_input(&fmt);
+            if (outFile)
+                fclose(outFile);
+            av_channel_layout_uninit(&out_ch_layout);
+            SetError("Failed to open codec");
+            return;
+        }
+        av_dict_free(&dec_opts);
+
+        int src_channels = c->ch_layout.nb_channels ? c->ch_layout.nb_channels : 1;
+        int src_sample_rate = c->sample_rate;
+        enum AVSampleFormat src_sample_fmt = c->sample_fmt;
+
         AVChannelLayout tmp_ch_layout;
-        const AVChannelLayout *in_ch_layout = &st->codecpar->ch_layout;
+        const AVChannelLayout *in_ch_layout = &c->ch_layout;
         if (in_ch_layout->nb_channels == 0)
         {
             av_channel_layout_default(&tmp_ch_layout, src_channels);
             in_ch_layout = &tmp_ch_layout;
         }
 
-        // 输出单声道
-        AVChannelLayout out_ch_layout = AV_CHANNEL_LAYOUT_MONO;
+        // 解码输出已与目标一致时(如 SILK 直接解码到目标采样率)跳过 swr
+        bool passthrough = src_sample_rate == out_sample_rate &&
+                           av_channel_layout_compare(in_ch_layout, &out_ch_layout) == 0 &&
+                           (src_sample_fmt == out_sample_fmt ||
+                            (out_channels == 1 && av_get_packed_sample_fmt(src_sample_fmt) == av_get_packed_sample_fmt(out_sample_fmt)));
+
+        // 采样率与声道一致、只差采样格式/排列时(如原生采样率解码为 f32)用专用转换循环
+        SampleConvertFn convert = nullptr;
+        if (!passthrough && out_channels <= AV_NUM_DATA_POINTERS &&
+            IsFormatOnlyConversion(in_ch_layout, src_sample_rate, &out_ch_layout, out_sample_rate))
+        {
+            convert = FindSampleConverter(src_sample_fmt, out_sample_fmt);
+        }
+
+        resampler_ = passthrough ? "none" : (convert ? "convert" : "swr");
 
+        // 由 swr 直接输出调用方要求的格式/声道/排列,JS 侧无需再转换
         SwrContext *swr = nullptr;
-        if (swr_alloc_set_opts2(&swr,
-                                &out_ch_layout, AV_SAMPLE_FMT_S16, out_sample_rate,
-                                in_ch_layout, src_sample_fmt, src_sample_rate,
-                                0, nullptr) < 0 ||
-            !swr)
+        if (!passthrough && !convert)
         {
-            if (swr)
+            if (swr_alloc_set_opts2(&swr,
+                                    &out_ch_layout, out_sample_fmt, out_sample_rate,
+                                    in_ch_layout, src_sample_fmt, src_sample_rate,
+                                    0, nullptr) < 0 ||
+                !swr)
+            {
+                if (swr)
+                    swr_free(&swr);
+                avcodec_free_context(&c);
+                avformat_close_input(&fmt);
+                if (outFile)
+                    fclose(outFile);
+                av_channel_layout_uninit(&out_ch_layout);
+                SetError("Failed to init resampler");
+                return;
+            }
+            ApplyResampleQuality(swr, options_.resampleQuality);
+            if (swr_init(swr) < 0)
+            {
                 swr_free(&swr);
-            avcodec_free_context(&c);
-            avformat_close_input(&fmt);
-            SetError("Failed to init resampler");
-            return;
+                avcodec_free_context(&c);
+                avformat_close_input(&fmt);
+                if (outFile)
+                    fclose(outFile);
+                av_channel_layout_uninit(&out_ch_layout);
+                SetError("Failed to init resampler");
+                return;
+            }
         }
-        if (swr_init(swr) < 0)
+
+        // 交错格式写文件时直接流式写出;平面格式或返回内存时按平面累积
+        int nb_planes = planar ? out_channels : 1;
+        bool stream_to_file = outFile && !planar;
+
+        // 分段: 每段采样数按输出采样率取整;交错格式写文件时在边界处换到下一个文件,
+        // 平面格式和内存输出在结束时按边界切分 (内存输出只记录边界,不拷贝)
+        segmentSamples_ = options_.segment > 0 ? (int64_t)(options_.segment * out_sample_rate + 0.5) : 0;
+        size_t frame_bytes = (size_t)bytes_per_sample * (planar ? 1 : out_channels);
+        size_t segment_bytes = (size_t)segmentSamples_ * frame_bytes;
+        size_t segment_written = 0;
+        auto write_file = [&](const uint8_t *bytes, size_t size)
         {
-            swr_free(&swr);
-            avcodec_free_context(&c);
-            avformat_close_input(&fmt);
-            SetError("Failed to init resampler");
-            return;
-        }
+            while (size > 0 && outFile)
+            {
+                size_t n = size;
+                if (segment_bytes > 0)
+                {
+                    // 上一段已满: 有新数据时才打开下一段,避免末尾生成空文件
+                    if (segment_written == segment_bytes)
+                    {
+                        fclose(outFile);
+                        segments_.push_back({SegmentOutputPath(outputPath_, (int)segments_.size()), (double)segmentSamples_ / out_sample_rate});
+                        outFile = fopen(SegmentOutputPath(outputPath_, (int)segments_.size()).c_str(), "wb");
+                        segment_written = 0;
+                        if (!outFile)
+                            return;
+                    }
+                    n = std::min(n, segment_bytes - segment_written);
+                }
+                fwrite(bytes, 1, n, outFile);
+                bytes += n;
+                size -= n;
+                segment_written += n;
+            }
+        };
+        planes_.assign(nb_planes, std::vector<uint8_t>());
+
+        std::vector<uint8_t> convert_out;
+
+        // 把转换结果追加到文件或平面缓冲
+        auto emit = [&](const uint8_t **in, int in_samples)
+        {
+            if (convert)
+            {
+                if (!in || in_samples <= 0)
+                    return;
+                size_t plane_bytes = (size_t)in_samples * bytes_per_sample * (planar ? 1 : out_channels);
+                uint8_t *dst[AV_NUM_DATA_POINTERS] = {nullptr};
+                if (stream_to_file)
+                {
+                    convert_out.resize(plane_bytes);
+                    dst[0] = convert_out.data();
+                    convert(dst, in, in_samples, out_channels);
+                    write_file(dst[0], plane_bytes);
+                    return;
+                }
+                // 直接转换到各平面缓冲的尾部
+                for (int p = 0; p < nb_planes; ++p)
+                {
+                    size_t used = planes_[p].size();
+                    planes_[p].resize(used + plane_bytes);
+                    dst[p] = planes_[p].data() + used;
+                }
+                convert(dst, in, in_samples, out_channels);
+                return;
+            }
+            if (!swr)
+            {
+                if (!in)
+                    return;
+                size_t plane_bytes = (size_t)in_samples * bytes_per_sample * (planar ? 1 : out_channels);
+                for (int p = 0; p < nb_planes; ++p)
+                {
+                    if (stream_to_file)
+                        write_file(in[p], plane_bytes);
+                    else
+                        planes_[p].insert(planes_[p].end(), in[p], in[p] + plane_bytes);
+                }
+                return;
+            }
+
+            int dst_nb_samples = swr_get_out_samples(swr, in_samples);
+            if (dst_nb_samples <= 0)
+                return;
+            uint8_t **dst = nullptr;
+            if (av_samples_alloc_array_and_samples(&dst, nullptr, out_channels, dst_nb_samples, out_sample_fmt, 0) < 0)
+                return;
+            int ret = swr_convert(swr, (uint8_t *const *)dst, dst_nb_samples, in, in_samples);
+            if (ret > 0)
+            {
+                size_t plane_bytes = (size_t)ret * bytes_per_sample * (planar ? 1 : out_channels);
+                for (int p = 0; p < nb_planes; ++p)
+                {
+                    if (stream_to_file)
+                        write_file(dst[p], plane_bytes);
+                    else
+                        planes_[p].insert(planes_[p].end(), dst[p], dst[p] + plane_bytes);
+                }
+            }
+            av_freep(&dst[0]);
+            av_freep(&dst);
+        };
+
+        // 只解码 [start, start + duration) 的窗口,越过结尾后不再读包
+        TimeWindow window(options_.start, options_.duration);
+        if (window.Active())
+            window.Seek(fmt, audStream);
 
         AVPacket *pkt = av_packet_alloc();
         AVFrame *frame = av_frame_alloc();
-        while (av_read_frame(fmt, pkt) >= 0)
+        while (!window.Done() && av_read_frame(fmt, pkt) >= 0)
         {
             if (pkt->stream_index == audStream)
             {
@@ -146,46 +338,73 @@ public:
                 {
                     while (avcodec_receive_frame(c, frame) == 0)
                     {
-                        uint8_t **dst = nullptr;
-                        int dst_nb_samples = swr_get_out_samples(swr, frame->nb_samples);
-                        if (dst_nb_samples <= 0)
-                            dst_nb_samples = frame->nb_samples;
-                        if (av_samples_alloc_array_and_samples(&dst, nullptr, 1, dst_nb_samples, AV_SAMPLE_FMT_S16, 0) < 0)
-                        {
-                            continue;
-                        }
-                        int ret = swr_convert(swr, (uint8_t *const *)dst, dst_nb_samples, (const uint8_t **)frame->data, frame->nb_samples);
-                        if (ret < 0)
-                        {
-                            av_freep(&dst[0]);
-                            av_freep(&dst);
+                        if (window.Active() && !window.Trim(frame))
                             continue;
-                        }
-                        int nb = av_samples_get_buffer_size(nullptr, 1, ret, AV_SAMPLE_FMT_S16, 1);
-                        if (outFile)
-                        {
-                            fwrite(dst[0], 1, nb, outFile);
-                        }
-                        av_freep(&dst[0]);
-                        av_freep(&dst);
+                        emit((const uint8_t **)frame->data, frame->nb_samples);
                     }
                 }
             }
             av_packet_unref(pkt);
         }
+
+        // 刷新解码器和重采样器
+        avcodec_send_packet(c, nullptr);
+        while (avcodec_receive_frame(c, frame) == 0)
+        {
+            if (window.Active() && !window.Trim(frame))
+                continue;
+            emit((const uint8_t **)frame->data, frame->nb_samples);
+        }
+        emit(nullptr, 0);
+
+        // 平面格式写文件: 按声道依次写入;分段时每段一个文件,段内同样按声道依次写入
+        if (outFile && !stream_to_file)
+        {
+            size_t total = planes_.empty() ? 0 : planes_[0].size();
+            size_t chunk = segment_bytes > 0 ? segment_bytes : total;
+            size_t offset = 0;
+            do
+            {
+                size_t n = std::min(chunk, total - offset);
+                if (offset > 0)
+                {
+                    fclose(outFile);
+                    outFile = fopen(SegmentOutputPath(outputPath_, (int)segments_.size()).c_str(), "wb");
+                    if (!outFile)
+                        break;
+                }
+                for (auto &plane : planes_)
+                    fwrite(plane.data() + offset, 1, n, outFile);
+                if (segment_bytes > 0)
+                    segments_.push_back({SegmentOutputPath(outputPath_, (int)segments_.size()), (double)(n / frame_bytes) / out_sample_rate});
+                offset += n;
+            } while (offset < total);
+            planes_.clear();
+        }
+        else if (outFile && segment_bytes > 0)
+        {
+            segments_.push_back({SegmentOutputPath(outputPath_, (int)segments_.size()), (double)(segment_written / frame_bytes) / out_sample_rate});
+        }
+
         av_frame_free(&frame);
         av_packet_free(&pkt);
-        swr_free(&swr);
+        if (swr)
+            swr_free(&swr);
         sampleRate_ = out_sample_rate;
-        channels_ = 1; // 输出单声道
+        channels_ = out_channels;
         avcodec_free_context(&c);
         avformat_close_input(&fmt);
+        av_channel_layout_uninit(&out_ch_layout);
 
         // 关闭输出文件
         if (outFile)
         {
             fclose(outFile);
         }
+        else if (!outputPath_.empty())
+        {
+            SetError("Failed to open output file");
+        }
     }
 
     void OnOK() override
@@ -194,6 +413,61 @@ public:
         Object res = Object::New(env);
         res.Set("result", Boolean::New(env, true));
         res.Set("sampleRate", Number::New(env, sampleRate_));
+        res.Set("channels", Number::New(env, channels_));
+        res.Set("sampleFormat", String::New(env, PcmSampleFormatName(options_.sampleFormat)));
+        res.Set("planar", Boolean::New(env, av_sample_fmt_is_planar(options_.sampleFormat) != 0));
+        res.Set("resampler", String::New(env, resampler_));
+
+        // 未指定输出文件时,直接返回原生内存上的 TypedArray
+        if (outputPath_.empty())
+        {
+            bool planar = av_sample_fmt_is_planar(options_.sampleFormat) != 0;
+            size_t frame_elems = planar ? 1 : (size_t)channels_;
+            size_t total = planes_.empty() ? 0 : planes_[0].size() / av_get_bytes_per_sample(options_.sampleFormat) / frame_elems;
+            std::vector<Value> arrays;
+            for (size_t i = 0; i < planes_.size(); ++i)
+                arrays.push_back(NewPcmTypedArray(env, std::move(planes_[i]), options_.sampleFormat));
+            if (planar)
+            {
+                Array pcm = Array::New(env, arrays.size());
+                for (size_t i = 0; i < arrays.size(); ++i)
+                    pcm.Set((uint32_t)i, arrays[i]);
+                res.Set("pcm", pcm);
+            }
+            else if (!arrays.empty())
+            {
+                res.Set("pcm", arrays[0]);
+            }
+
+            // 分段: 每段是整块 PCM 上的视图,与 pcm 共享内存
+            if (segmentSamples_ > 0)
+            {
+                Array segments = Array::New(env);
+                for (size_t offset = 0, k = 0; offset < total; offset += segmentSamples_, ++k)
+                {
+                    size_t n = std::min<size_t>(segmentSamples_, total - offset);
+                    Object item = Object::New(env);
+                    if (planar)
+                    {
+                        Array views = Array::New(env, arrays.size());
+                        for (size_t i = 0; i < arrays.size(); ++i)
+                            views.Set((uint32_t)i, PcmSubarray(env, arrays[i], offset, n));
+                        item.Set("pcm", views);
+                    }
+                    else
+                    {
+                        item.Set("pcm", PcmSubarray(env, arrays[0], offset * frame_elems, n * frame_elems));
+                    }
+                    item.Set("duration", Number::New(env, (double)n / sampleRate_));
+                    segments.Set((uint32_t)k, item);
+                }
+                res.Set("segments", segments);
+            }
+        }
+        else if (segmentSamples_ > 0)
+        {
+            res.Set("segments", NewSegmentArray(env, segments_));
+        }
         deferred_.Resolve(res);
     }
 
@@ -203,36 +477,123 @@ public:
     }
 
 private:
+    // 在同一块内存上创建 [offset, offset + length) 个元素的视图,不拷贝
+    static Value PcmSubarray(Napi::Env env, const Value &whole, size_t offset, size_t length)
+    {
+        TypedArray arr = whole.As<TypedArray>();
+        Napi::ArrayBuffer ab = arr.ArrayBuffer();
+        size_t byteOffset = arr.ByteOffset() + offset * arr.ElementSize();
+        switch (arr.TypedArrayType())
+        {
+        case napi_int32_array:
+            return TypedArrayOf<int32_t>::New(env, length, ab, byteOffset);
+        case napi_float32_array:
+            return TypedArrayOf<float>::New(env, length, ab, byteOffset);
+        default:
+            return TypedArrayOf<int16_t>::New(env, length, ab, byteOffset);
+        }
+    }
+
     std::string inputPath_;
     std::string outputPath_;
-    int targetSampleRate_;
+    PcmOutputOptions options_;
     Promise::Deferred deferred_;
     int sampleRate_;
     int channels_;
+    std::vector<std::vector<uint8_t>> planes_;
+    std::string resampler_;
+    int64_t segmentSamples_ = 0;
+    std::vector<OutputSegment> segments_;
 };
 
+// decodeAudioToPCM(inputPath, outputPath?, sampleRate | options?) -> Promise
+// options: { sampleRate, sampleFormat: 's16' | 's32' | 'f32', channels, channelLayout, planar,
+//           resampleQuality: 'fast' | 'default' | 'high', start, duration, segment }
+// start / duration 单位为秒: seek 到 start 之前最近的可 seek 点,按采样精确裁剪,只解码窗口内的数据
+// segment 单位为秒: 按采样精确分段;写文件时每段一个文件 (路径含 %d 时按它编号,否则为 name_000.ext 形式),
+// 返回内存时 segments 为 pcm 上的视图
+// outputPath 为空时结果以 pcm (Int16Array / Int32Array / Float32Array, planar 时为按声道的数组) 返回
 Value DecodeAudioToPCM(const CallbackInfo &info)
 {
     Env env = info.Env();
-    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString())
+    if (info.Length() < 1 || !info[0].IsString() ||
+        (info.Length() >= 2 && !info[1].IsString() && !info[1].IsNull() && !info[1].IsUndefined()))
     {
-        TypeError::New(env, "Expected inputPath (string) and outputPath (string)").ThrowAsJavaScriptException();
+        TypeError::New(env, "Expected inputPath (string) and optional outputPath (string)").ThrowAsJavaScriptException();
         return env.Null();
     }
     
     std::string inputPath = info[0].As<String>().Utf8Value();
-    std::string outputPath = info[1].As<String>().Utf8Value();
+    std::string outputPath;
+    if (info.Length() >= 2 && info[1].IsString())
+    {
+        outputPath = info[1].As<String>().Utf8Value();
+    }
     
-    // 第三个参数可选:目标采样率
-    int targetSampleRate = 0; // 0 表示不改变采样率
+    // 第三个参数可选:目标采样率,或输出参数对象
+    PcmOutputOptions options;
     if (info.Length() >= 3 && info[2].IsNumber())
     {
-        targetSampleRate = info[2].As<Number>().Int32Value();
+        options.sampleRate = info[2].As<Number>().Int32Value();
+    }
+    else if (info.Length() >= 3 && info[2].IsObject())
+    {
+        Object opts = info[2].As<Object>();
+        if (opts.Has("sampleRate") && opts.Get("sampleRate").IsNumber())
+        {
+            options.sampleRate = opts.Get("sampleRate").As<Number>().Int32Value();
+        }
+        bool planar = opts.Has("planar") && opts.Get("planar").ToBoolean().Value();
+        std::string sampleFormat = "s16";
+        if (opts.Has("sampleFormat") && opts.Get("sampleFormat").IsString())
+        {
+            sampleFormat = opts.Get("sampleFormat").As<String>().Utf8Value();
+        }
+        options.sampleFormat = ParsePcmSampleFormat(sampleFormat, planar);
+        if (options.sampleFormat == AV_SAMPLE_FMT_NONE)
+        {
+            TypeError::New(env, "Unsupported sampleFormat. Supported: s16, s32, f32").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (opts.Has("channelLayout") && opts.Get("channelLayout").IsString())
+        {
+            options.channelLayout = opts.Get("channelLayout").As<String>().Utf8Value();
+        }
+        if (opts.Has("start") && opts.Get("start").IsNumber())
+            options.start = opts.Get("start").As<Number>().DoubleValue();
+        if (opts.Has("duration") && opts.Get("duration").IsNumber())
+            options.duration = opts.Get("duration").As<Number>().DoubleValue();
+        if (options.start < 0 || options.duration < 0)
+        {
+            TypeError::New(env, "start and duration must not be negative").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (opts.Has("segment") && opts.Get("segment").IsNumber())
+            options.segment = opts.Get("segment").As<Number>().DoubleValue();
+        if (options.segment < 0)
+        {
+            TypeError::New(env, "segment must not be negative").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (opts.Has("resampleQuality") && opts.Get("resampleQuality").IsString() &&
+            !ParseResampleQuality(opts.Get("resampleQuality").As<String>().Utf8Value(), options.resampleQuality))
+        {
+            TypeError::New(env, "resampleQuality must be 'fast', 'default' or 'high'").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (opts.Has("channels") && opts.Get("channels").IsNumber())
+        {
+            options.channels = opts.Get("channels").As<Number>().Int32Value();
+            if (options.channels < 1 || options.channels > 8)
+            {
+                TypeError::New(env, "channels must be between 1 and 8").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+        }
     }
     
     Promise::Deferred deferred = Promise::Deferred::New(env);
-    DecodeAudioToPCMWorker *worker = new DecodeAudioToPCMWorker(inputPath, outputPath, targetSampleRate, deferred);
+    DecodeAudioToPCMWorker *worker = new DecodeAudioToPCMWorker(inputPath, outputPath, options, deferred);
     worker->Queue();
     return deferred.Promise();
 }
-
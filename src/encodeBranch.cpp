@@ -0,0 +1,696 @@
+#include "encodeBranch.h"
+#include <algorithm>
+
+void EncodeBranch::Reset(const OutputSpec &spec)
+{
+    spec_ = spec;
+    error_.clear();
+    pts_ = 0;
+    headerWritten_ = false;
+    finishing_ = false;
+    segments_.clear();
+    segmentPending_ = false;
+}
+
+bool EncodeBranch::Open(const AVCodecContext *dec)
+{
+    enum AVCodecID codec_id;
+    enum AVSampleFormat sample_fmt;
+    const char *muxer;
+    int bit_rate;
+    int out_rate;
+    if (spec_.type == "silk")
+    {
+        codec_id = AV_CODEC_ID_NTSILK_S16LE;
+        sample_fmt = AV_SAMPLE_FMT_S16;
+        muxer = "ntsilk_s16le";
+        bit_rate = spec_.bitrate;
+        out_rate = std::min(dec->sample_rate, SilkInternalSampleRate(spec_.bitrate));
+        if (!IsSilkApiSampleRate(out_rate))
+            out_rate = SilkInternalSampleRate(spec_.bitrate);
+    }
+    else
+    {
+        const FormatConfig &config = *spec_.format;
+        codec_id = config.codec_id;
+        sample_fmt = config.sample_fmt;
+        muxer = config.format_name;
+        bit_rate = config.bit_rate;
+        out_rate = spec_.sampleRate;
+        if (out_rate <= 0)
+        {
+            // 与 decodeAudioToFmt 相同: 选择最接近输入的常用采样率
+            const int supported_rates[] = {48000, 44100, 32000, 24000, 16000, 12000, 8000};
+            out_rate = supported_rates[0];
+            for (int rate : supported_rates)
+            {
+                if (abs(dec->sample_rate - rate) < abs(dec->sample_rate - out_rate))
+                    out_rate = rate;
+            }
+        }
+        // AMR只支持8000Hz采样率
+        if (codec_id == AV_CODEC_ID_AMR_NB)
+            out_rate = 8000;
+    }
+
+    EncoderKey key;
+    key.codecId = codec_id;
+    key.sampleRate = out_rate;
+    key.bitRate = bit_rate;
+    if (codec_id == AV_CODEC_ID_NTSILK_S16LE)
+    {
+        key.complexity = spec_.complexity;
+        key.packetSize = spec_.packetSize;
+        key.dtx = spec_.dtx;
+        key.fec = spec_.fec;
+        key.packetLoss = spec_.packetLoss;
+    }
+    if (!OpenEncoder(key, sample_fmt))
+        return false;
+    sampleRate_ = out_rate;
+
+    // 固定帧长的编码器按帧长切分;可变帧长的编码器 (PCM 等) 每次送一块
+    int caps = enc_->codec->capabilities;
+    bool variable = enc_->frame_size <= 0 || (caps & AV_CODEC_CAP_VARIABLE_FRAME_SIZE);
+    frameSize_ = variable ? 4096 : enc_->frame_size;
+    padTail_ = !variable && !(caps & AV_CODEC_CAP_SMALL_LAST_FRAME);
+
+    // 分段输出: 每段 segment 秒 (按输出采样率取整),文件名由 spec_.path 生成
+    muxer_ = muxer;
+    encSampleFmt_ = sample_fmt;
+    segmentSamples_ = spec_.segment > 0 ? (int64_t)(spec_.segment * out_rate + 0.5) : 0;
+    if (!OpenOutput(segmentSamples_ > 0 ? SegmentOutputPath(spec_.path, 0) : spec_.path))
+        return false;
+
+    if (!OpenResampler(dec))
+        return false;
+
+    if (fifo_ && fifoFormat_ != enc_->sample_fmt)
+    {
+        av_audio_fifo_free(fifo_);
+        fifo_ = nullptr;
+    }
+    if (fifo_)
+        av_audio_fifo_reset(fifo_);
+    else
+        fifo_ = av_audio_fifo_alloc(enc_->sample_fmt, 1, frameSize_ * 2);
+    fifoFormat_ = enc_->sample_fmt;
+    trimmer_.reset(spec_.trimSilence.enabled ? new SilenceTrimmer(spec_.trimSilence, enc_->sample_fmt, out_rate) : nullptr);
+    if (trimmer_ && !trimmer_->Valid())
+    {
+        Fail("Failed to allocate silence trimmer");
+        return false;
+    }
+    if (!resampled_)
+        resampled_ = av_frame_alloc();
+    if (!encFrame_)
+        encFrame_ = av_frame_alloc();
+    if (!pkt_)
+        pkt_ = av_packet_alloc();
+    if (!fifo_ || !resampled_ || !encFrame_ || !pkt_)
+    {
+        Fail("Failed to allocate buffers");
+        return false;
+    }
+    return true;
+}
+
+bool EncodeBranch::OpenOutput(const std::string &path)
+{
+    if (avformat_alloc_output_context2(&out_, nullptr, muxer_, path.c_str()) < 0 || !out_)
+    {
+        Fail("Failed to create output context");
+        return false;
+    }
+    stream_ = avformat_new_stream(out_, nullptr);
+    if (!stream_ || avcodec_parameters_from_context(stream_->codecpar, enc_) < 0)
+    {
+        Fail("Failed to create output stream");
+        return false;
+    }
+    stream_->time_base = enc_->time_base;
+    if (!(out_->oformat->flags & AVFMT_NOFILE) && avio_open(&out_->pb, path.c_str(), AVIO_FLAG_WRITE) < 0)
+    {
+        Fail("Failed to open output file");
+        return false;
+    }
+    if (avformat_write_header(out_, nullptr) < 0)
+    {
+        Fail("Failed to write header");
+        return false;
+    }
+    headerWritten_ = true;
+    outputPath_ = path;
+    return true;
+}
+
+// 当前分段到达边界: 冲刷编码器、写文件尾并关闭,下一段在有数据时才打开 (避免末尾生成空文件)
+void EncodeBranch::EndSegment()
+{
+    avcodec_send_frame(enc_, nullptr);
+    WritePackets();
+    if (Failed())
+        return;
+    if (av_write_trailer(out_) < 0)
+    {
+        Fail("Failed to write trailer");
+        return;
+    }
+    segments_.push_back({outputPath_, (double)pts_ / enc_->sample_rate});
+    CloseOutput();
+    segmentPending_ = true;
+}
+
+// 打开下一段: 重新打开编码器,复用器换新文件,时间戳从 0 开始
+bool EncodeBranch::StartSegment()
+{
+    segmentPending_ = false;
+    pts_ = 0;
+    return OpenEncoder(encKey_, encSampleFmt_) && OpenOutput(SegmentOutputPath(spec_.path, (int)segments_.size()));
+}
+
+bool EncodeBranch::OpenResampler(const AVCodecContext *dec)
+{
+    // 每个分支自己的重采样器,输入参数取自解码器;已有的上下文原地重新配置
+    // swr 的质量选项不会被 swr_alloc_set_opts2 重置,档位变化时重新分配
+    if (swr_ && swrQuality_ != spec_.resampleQuality)
+        swr_free(&swr_);
+    if (swr_)
+        swr_close(swr_);
+    AVChannelLayout in_layout;
+    if (dec->ch_layout.nb_channels > 0)
+        av_channel_layout_copy(&in_layout, &dec->ch_layout);
+    else
+        av_channel_layout_default(&in_layout, 1);
+    int ret = swr_alloc_set_opts2(&swr_, &enc_->ch_layout, enc_->sample_fmt, enc_->sample_rate,
+                                  &in_layout, dec->sample_fmt, dec->sample_rate, 0, nullptr);
+    av_channel_layout_uninit(&in_layout);
+    if (ret < 0 || !swr_)
+    {
+        Fail("Failed to initialize resampler");
+        return false;
+    }
+    swrQuality_ = spec_.resampleQuality;
+    ApplyResampleQuality(swr_, spec_.resampleQuality);
+    if (swr_init(swr_) < 0)
+    {
+        Fail("Failed to initialize resampler");
+        return false;
+    }
+    return true;
+}
+
+bool EncodeBranch::ChangeInput(const AVCodecContext *dec)
+{
+    if (Failed())
+        return false;
+    // 上一个输入留在重采样器里的尾部采样先写入 FIFO,FIFO 和时间戳继续累加
+    if (!Resample(nullptr))
+        return false;
+    EncodeFifo(false);
+    return !Failed() && OpenResampler(dec);
+}
+
+bool EncodeBranch::OpenEncoder(const EncoderKey &key, enum AVSampleFormat sampleFmt)
+{
+    // 编码器冲刷后不能继续使用 (启用的编码器都没有 AV_CODEC_CAP_ENCODER_FLUSH),每个输出/分段都重新打开
+    avcodec_free_context(&enc_);
+
+    const AVCodec *encoder = avcodec_find_encoder(key.codecId);
+    if (!encoder)
+    {
+        Fail("Encoder not found");
+        return false;
+    }
+    enc_ = avcodec_alloc_context3(encoder);
+    if (!enc_)
+    {
+        Fail("Failed to allocate encoder");
+        return false;
+    }
+    enc_->sample_rate = key.sampleRate;
+    enc_->ch_layout = AV_CHANNEL_LAYOUT_MONO;
+    enc_->time_base = {1, key.sampleRate};
+    enc_->sample_fmt = sampleFmt;
+    if (encoder->sample_fmts && encoder->sample_fmts[0] != AV_SAMPLE_FMT_NONE)
+    {
+        const enum AVSampleFormat *p = encoder->sample_fmts;
+        while (*p != AV_SAMPLE_FMT_NONE && *p != sampleFmt)
+            p++;
+        if (*p == AV_SAMPLE_FMT_NONE)
+            enc_->sample_fmt = encoder->sample_fmts[0];
+    }
+    if (key.bitRate > 0)
+        enc_->bit_rate = key.bitRate;
+    if (key.codecId == AV_CODEC_ID_FLAC)
+        enc_->compression_level = 5;
+
+    AVDictionary *enc_opts = nullptr;
+    if (key.codecId == AV_CODEC_ID_NTSILK_S16LE)
+    {
+        av_dict_set_int(&enc_opts, "complexity", key.complexity, 0);
+        av_dict_set_int(&enc_opts, "dtx", key.dtx ? 1 : 0, 0);
+        av_dict_set_int(&enc_opts, "fec", key.fec ? 1 : 0, 0);
+        av_dict_set_int(&enc_opts, "packet_loss", key.packetLoss, 0);
+        av_dict_set_int(&enc_opts, "packet_size", key.packetSize, 0);
+    }
+    int ret = avcodec_open2(enc_, encoder, &enc_opts);
+    av_dict_free(&enc_opts);
+    if (ret < 0)
+    {
+        avcodec_free_context(&enc_);
+        Fail("Failed to open encoder");
+        return false;
+    }
+    encKey_ = key;
+    return true;
+}
+
+void EncodeBranch::Push(const AVFrame *frame)
+{
+    if (!thread_.joinable())
+    {
+        if (!Failed())
+            Consume(frame);
+        return;
+    }
+
+    AVFrame *ref = av_frame_clone(frame);
+    if (!ref)
+        return;
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]
+             { return queue_.size() < MAX_QUEUED_FRAMES; });
+    queue_.push_back(ref);
+    cv_.notify_all();
+}
+
+void EncodeBranch::Run()
+{
+    for (;;)
+    {
+        AVFrame *frame = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]
+                     { return !queue_.empty() || finishing_; });
+            if (queue_.empty())
+                break;
+            frame = queue_.front();
+            queue_.pop_front();
+            cv_.notify_all();
+        }
+        // 出错后继续取帧释放,避免解码线程在满队列上阻塞
+        if (!Failed())
+            Consume(frame);
+        av_frame_free(&frame);
+    }
+    if (!Failed())
+        Consume(nullptr);
+}
+
+void EncodeBranch::Finish()
+{
+    if (thread_.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            finishing_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+    else if (!Failed())
+    {
+        Consume(nullptr);
+    }
+
+    if (headerWritten_ && !Failed())
+    {
+        if (av_write_trailer(out_) < 0)
+            Fail("Failed to write trailer");
+        else if (segmentSamples_ > 0)
+            segments_.push_back({outputPath_, (double)pts_ / enc_->sample_rate});
+    }
+    CloseOutput();
+}
+
+void EncodeBranch::Join()
+{
+    if (!thread_.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finishing_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+bool EncodeBranch::Resample(const AVFrame *frame)
+{
+    int in_samples = frame ? frame->nb_samples : 0;
+    int out_samples = swr_get_out_samples(swr_, in_samples);
+    if (out_samples > 0)
+    {
+        resampled_->format = enc_->sample_fmt;
+        resampled_->sample_rate = enc_->sample_rate;
+        resampled_->nb_samples = out_samples;
+        av_channel_layout_copy(&resampled_->ch_layout, &enc_->ch_layout);
+        if (av_frame_get_buffer(resampled_, 0) < 0)
+        {
+            Fail("Failed to allocate resample buffer");
+            return false;
+        }
+        int converted = swr_convert(swr_, resampled_->data, out_samples,
+                                    frame ? (const uint8_t **)frame->extended_data : nullptr, in_samples);
+        if (converted > 0 && trimmer_)
+        {
+            if (trimmer_->Process(resampled_->data[0], converted, fifo_) < 0)
+                Fail("Failed to write FIFO");
+        }
+        else if (converted > 0 && av_audio_fifo_write(fifo_, (void **)resampled_->data, converted) < converted)
+            Fail("Failed to write FIFO");
+        av_frame_unref(resampled_);
+        if (converted < 0)
+            Fail("Resample failed");
+    }
+    return !Failed();
+}
+
+void EncodeBranch::Consume(const AVFrame *frame)
+{
+    if (!Resample(frame))
+        return;
+    // 输入结束时由裁剪器决定尾部暂存的静音是丢弃还是补回
+    if (!frame && trimmer_ && trimmer_->Finish(fifo_) < 0)
+    {
+        Fail("Failed to write FIFO");
+        return;
+    }
+    EncodeFifo(frame == nullptr);
+    if (!frame && !Failed() && !segmentPending_)
+    {
+        avcodec_send_frame(enc_, nullptr);
+        WritePackets();
+    }
+}
+
+void EncodeBranch::EncodeFifo(bool flush)
+{
+    for (;;)
+    {
+        // 分段时一帧不跨越边界: 边界前不足一帧的部分单独作为本段最后一帧
+        int available = av_audio_fifo_size(fifo_);
+        int limit = frameSize_;
+        if (segmentSamples_ > 0)
+            limit = (int)std::min<int64_t>(limit, segmentSamples_ - (segmentPending_ ? 0 : pts_));
+        if (Failed() || available <= 0 || (available < limit && !flush))
+            break;
+        if (segmentPending_ && !StartSegment())
+            break;
+
+        int n = std::min(available, limit);
+        encFrame_->format = enc_->sample_fmt;
+        encFrame_->sample_rate = enc_->sample_rate;
+        encFrame_->nb_samples = padTail_ ? frameSize_ : n;
+        av_channel_layout_copy(&encFrame_->ch_layout, &enc_->ch_layout);
+        if (av_frame_get_buffer(encFrame_, 0) < 0)
+        {
+            Fail("Failed to allocate encoder frame");
+            return;
+        }
+        av_audio_fifo_read(fifo_, (void **)encFrame_->data, n);
+        if (n < encFrame_->nb_samples)
+            av_samples_set_silence(encFrame_->data, n, encFrame_->nb_samples - n, 1, enc_->sample_fmt);
+        encFrame_->pts = pts_;
+        pts_ += n;
+
+        int ret = avcodec_send_frame(enc_, encFrame_);
+        av_frame_unref(encFrame_);
+        if (ret < 0)
+        {
+            Fail("Failed to encode frame");
+            return;
+        }
+        WritePackets();
+        if (segmentSamples_ > 0 && pts_ >= segmentSamples_)
+            EndSegment();
+    }
+}
+
+void EncodeBranch::WritePackets()
+{
+    while (avcodec_receive_packet(enc_, pkt_) == 0)
+    {
+        pkt_->stream_index = stream_->index;
+        av_packet_rescale_ts(pkt_, enc_->time_base, stream_->time_base);
+        if (av_interleaved_write_frame(out_, pkt_) < 0)
+        {
+            av_packet_unref(pkt_);
+            Fail("Failed to write packet");
+            return;
+        }
+    }
+}
+
+void EncodeBranch::Fail(const char *message)
+{
+    if (error_.empty())
+        error_ = message;
+}
+
+void EncodeBranch::CloseOutput()
+{
+    if (out_)
+    {
+        if (!(out_->oformat->flags & AVFMT_NOFILE))
+            avio_closep(&out_->pb);
+        avformat_free_context(out_);
+        out_ = nullptr;
+        stream_ = nullptr;
+    }
+    headerWritten_ = false;
+}
+
+void EncodeBranch::Cleanup()
+{
+    if (swr_)
+        swr_free(&swr_);
+    if (fifo_)
+    {
+        av_audio_fifo_free(fifo_);
+        fifo_ = nullptr;
+    }
+    av_frame_free(&resampled_);
+    av_frame_free(&encFrame_);
+    av_packet_free(&pkt_);
+    avcodec_free_context(&enc_);
+}
+
+bool OpenDecodeInput(const MediaInput &input, AVDictionary *decoderOpts, AVFormatContext **fmt, int *stream,
+                     AVCodecContext **dec, std::string &error)
+{
+    if (OpenMediaInput(fmt, input) < 0)
+    {
+        error = "Failed to open input";
+        return false;
+    }
+    if (avformat_find_stream_info(*fmt, nullptr) < 0)
+    {
+        CloseMediaInput(fmt);
+        error = "Failed to find stream info";
+        return false;
+    }
+    *stream = av_find_best_stream(*fmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (*stream < 0)
+    {
+        CloseMediaInput(fmt);
+        error = "No audio stream";
+        return false;
+    }
+    for (unsigned i = 0; i < (*fmt)->nb_streams; i++)
+    {
+        if ((int)i != *stream)
+            (*fmt)->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    AVStream *st = (*fmt)->streams[*stream];
+    const AVCodec *codec = avcodec_find_decoder(st->codecpar->codec_id);
+    *dec = codec ? avcodec_alloc_context3(codec) : nullptr;
+    AVDictionary *opts = nullptr;
+    av_dict_copy(&opts, decoderOpts, 0);
+    int ret = *dec ? avcodec_parameters_to_context(*dec, st->codecpar) : -1;
+    if (ret >= 0)
+        ret = avcodec_open2(*dec, codec, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+    {
+        avcodec_free_context(dec);
+        CloseMediaInput(fmt);
+        error = "Failed to open decoder";
+        return false;
+    }
+    return true;
+}
+
+int64_t DecodeIntoBranch(AVFormatContext *fmt, int stream, AVCodecContext *dec, EncodeBranch &branch,
+                         TimeWindow *window, int &sampleRate)
+{
+    bool windowed = window && window->Active();
+    if (windowed)
+        window->Seek(fmt, stream); // 不能 seek 时从头解码,由 Trim 丢弃窗口之前的采样
+
+    int64_t samples = 0;
+    sampleRate = dec->sample_rate;
+    AVPacket *pkt = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+    auto push = [&]()
+    {
+        while (avcodec_receive_frame(dec, frame) == 0)
+        {
+            if (!windowed || window->Trim(frame))
+            {
+                sampleRate = frame->sample_rate;
+                samples += frame->nb_samples;
+                branch.Push(frame);
+            }
+            av_frame_unref(frame);
+        }
+    };
+    while (!branch.Failed() && !(windowed && window->Done()) && av_read_frame(fmt, pkt) >= 0)
+    {
+        if (pkt->stream_index == stream && avcodec_send_packet(dec, pkt) == 0)
+            push();
+        av_packet_unref(pkt);
+    }
+    avcodec_send_packet(dec, nullptr);
+    push();
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    return samples;
+}
+
+Value NewSegmentArray(Napi::Env env, const std::vector<OutputSegment> &segments)
+{
+    Array list = Array::New(env, segments.size());
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        Object item = Object::New(env);
+        item.Set("path", String::New(env, segments[i].path));
+        item.Set("duration", Number::New(env, segments[i].duration));
+        list.Set((uint32_t)i, item);
+    }
+    return list;
+}
+
+bool ParseOutputSpec(Napi::Env env, const Napi::Value &value, OutputSpec &spec)
+{
+    if (!value.IsObject())
+    {
+        TypeError::New(env, "Each output must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+    Object opts = value.As<Object>();
+    if (!opts.Get("type").IsString())
+    {
+        TypeError::New(env, "Output type must be 'audio', 'silk', 'duration' or 'waveform'").ThrowAsJavaScriptException();
+        return false;
+    }
+    spec.type = opts.Get("type").As<String>().Utf8Value();
+
+    if (spec.type == "audio" || spec.type == "silk")
+    {
+        if (!opts.Get("path").IsString())
+        {
+            TypeError::New(env, "Encoding outputs require a path string").ThrowAsJavaScriptException();
+            return false;
+        }
+        spec.path = opts.Get("path").As<String>().Utf8Value();
+        if (opts.Has("resampleQuality") && opts.Get("resampleQuality").IsString() &&
+            !ParseResampleQuality(opts.Get("resampleQuality").As<String>().Utf8Value(), spec.resampleQuality))
+        {
+            TypeError::New(env, "resampleQuality must be 'fast', 'default' or 'high'").ThrowAsJavaScriptException();
+            return false;
+        }
+        if (opts.Has("trimSilence") && !opts.Get("trimSilence").IsUndefined() &&
+            !ParseSilenceTrimOptions(env, opts.Get("trimSilence"), spec.trimSilence))
+            return false;
+    }
+
+    if (spec.type == "audio")
+    {
+        std::string format = opts.Get("format").IsString() ? opts.Get("format").As<String>().Utf8Value() : "";
+        spec.format = FindFormatConfig(format);
+        if (!spec.format)
+        {
+            TypeError::New(env, "Unsupported output format. Supported formats: mp3, amr, wma, m4a, spx, ogg, wav, flac").ThrowAsJavaScriptException();
+            return false;
+        }
+        if (opts.Has("sampleRate") && opts.Get("sampleRate").IsNumber())
+            spec.sampleRate = opts.Get("sampleRate").As<Number>().Int32Value();
+    }
+    else if (spec.type == "silk")
+    {
+        if (opts.Has("bitrate") && opts.Get("bitrate").IsNumber())
+            spec.bitrate = opts.Get("bitrate").As<Number>().Int32Value();
+        if (opts.Has("complexity") && opts.Get("complexity").IsNumber())
+            spec.complexity = opts.Get("complexity").As<Number>().Int32Value();
+        if (opts.Has("packetSize") && opts.Get("packetSize").IsNumber())
+            spec.packetSize = opts.Get("packetSize").As<Number>().Int32Value();
+        if (opts.Has("dtx"))
+            spec.dtx = opts.Get("dtx").ToBoolean().Value();
+        if (opts.Has("fec"))
+            spec.fec = opts.Get("fec").ToBoolean().Value();
+        if (opts.Has("packetLoss") && opts.Get("packetLoss").IsNumber())
+            spec.packetLoss = opts.Get("packetLoss").As<Number>().Int32Value();
+        if (spec.bitrate < 5000 || spec.bitrate > 60000)
+        {
+            TypeError::New(env, "bitrate must be between 5000 and 60000").ThrowAsJavaScriptException();
+            return false;
+        }
+        if (spec.complexity < 0 || spec.complexity > 2)
+        {
+            TypeError::New(env, "complexity must be 0, 1 or 2").ThrowAsJavaScriptException();
+            return false;
+        }
+        if (spec.packetSize < 20 || spec.packetSize > 100 || spec.packetSize % 20 != 0)
+        {
+            TypeError::New(env, "packetSize must be 20, 40, 60, 80 or 100").ThrowAsJavaScriptException();
+            return false;
+        }
+        if (spec.packetLoss < 0 || spec.packetLoss > 100)
+        {
+            TypeError::New(env, "packetLoss must be between 0 and 100").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+    else if (spec.type == "waveform")
+    {
+        if (opts.Has("buckets") && opts.Get("buckets").IsNumber())
+            spec.buckets = opts.Get("buckets").As<Number>().Int32Value();
+        if (spec.buckets < 1 || spec.buckets > 1000000)
+        {
+            TypeError::New(env, "buckets must be between 1 and 1000000").ThrowAsJavaScriptException();
+            return false;
+        }
+        if (opts.Has("sampleFormat") && opts.Get("sampleFormat").IsString())
+        {
+            std::string name = opts.Get("sampleFormat").As<String>().Utf8Value();
+            if (name == "s16")
+                spec.peakFormat = AV_SAMPLE_FMT_S16;
+            else if (name != "f32")
+            {
+                TypeError::New(env, "Unsupported sampleFormat. Supported: s16, f32").ThrowAsJavaScriptException();
+                return false;
+            }
+        }
+    }
+    else if (spec.type != "duration")
+    {
+        TypeError::New(env, "Output type must be 'audio', 'silk', 'duration' or 'waveform'").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+#include "audioCommon.h"
+#include "decodeAudio.h"
+#include "mediaInput.h"
+#include "silenceTrim.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// 一个编码输出 (或分析输出) 的参数,在 JS 线程上解析
+struct OutputSpec
+{
+    std::string type;  // audio / silk / duration / waveform
+    std::string path;
+    const FormatConfig *format = nullptr; // audio
+    int sampleRate = 0;                   // audio: 0 表示自动选择最接近的采样率
+    ResampleQuality resampleQuality = ResampleQuality::Default;
+    int bitrate = 30000;                  // silk
+    int complexity = 2;
+    int packetSize = 20;
+    bool dtx = false;
+    bool fec = false;
+    int packetLoss = 0;
+    int buckets = 1000;                   // waveform
+    enum AVSampleFormat peakFormat = AV_SAMPLE_FMT_FLT;
+    double segment = 0;                   // 编码输出按此秒数切分成多个文件,0 表示不切分
+    SilenceTrimOptions trimSilence;       // 编码前裁掉首尾静音
+};
+
+// 分段输出中已完成的一个文件
+struct OutputSegment
+{
+    std::string path;
+    double duration; // 秒
+};
+
+// 分段结果转成 [{ path, duration }]
+Value NewSegmentArray(Napi::Env env, const std::vector<OutputSegment> &segments);
+
+// 解析 process / transcodeMany 的输出项,出错时抛出 TypeError 并返回 false
+bool ParseOutputSpec(Napi::Env env, const Napi::Value &value, OutputSpec &spec);
+
+// 编码分支: 重采样 -> FIFO -> 编码 -> 复用,可以在独立线程上运行
+// 解码线程通过 Push 送入解码帧的引用 (av_frame_clone 不复制采样数据),队列有上限防止内存堆积
+// Finish 之后可用 Reset 换一个输出继续使用: 编码器每次重新打开,重采样器和帧缓冲复用
+class EncodeBranch
+{
+public:
+    EncodeBranch() {}
+    explicit EncodeBranch(const OutputSpec &spec) : spec_(spec) {}
+    ~EncodeBranch()
+    {
+        Join();
+        CloseOutput();
+        Cleanup();
+    }
+
+    // 换成新的输出参数,清除上一个输出的状态 (必须在 Finish 之后调用)
+    void Reset(const OutputSpec &spec);
+    // 按解码器输出参数打开重采样器、编码器和输出文件
+    bool Open(const AVCodecContext *dec);
+    // 启动编码线程;不启动时 Push / Finish 在调用线程上直接编码
+    void Start() { thread_ = std::thread(&EncodeBranch::Run, this); }
+    void Push(const AVFrame *frame);
+    // 切换到下一个输入 (拼接): 冲出重采样器中的剩余采样后按新解码器重新配置,
+    // 编码器、FIFO、时间戳和输出文件保持不变;只能在不启动线程时使用
+    bool ChangeInput(const AVCodecContext *dec);
+    // 冲刷编码器、写文件尾并关闭输出文件;线程模式下等待线程退出
+    void Finish();
+
+    bool Failed() const { return !error_.empty(); }
+    const std::string &Error() const { return error_; }
+    int SampleRate() const { return sampleRate_; }
+    // 本次 Open 是否复用了上一个输出的编码器
+    // 分段输出时已写完的文件 (Finish 之后完整)
+    const std::vector<OutputSegment> &Segments() const { return segments_; }
+    // 启用 trimSilence 时裁掉的首尾静音 (秒)
+    bool Trimming() const { return trimmer_ != nullptr; }
+    double TrimmedHead() const { return trimmer_ ? trimmer_->HeadTrimmed() : 0; }
+    double TrimmedTail() const { return trimmer_ ? trimmer_->TailTrimmed() : 0; }
+
+private:
+    static const size_t MAX_QUEUED_FRAMES = 32;
+
+    // 打开编码器的参数,分段时按它重新打开
+    struct EncoderKey
+    {
+        enum AVCodecID codecId = AV_CODEC_ID_NONE;
+        int sampleRate = 0;
+        int bitRate = 0;
+        int complexity = 0;
+        int packetSize = 0;
+        bool dtx = false;
+        bool fec = false;
+        int packetLoss = 0;
+    };
+
+    bool OpenEncoder(const EncoderKey &key, enum AVSampleFormat sampleFmt);
+    bool OpenResampler(const AVCodecContext *dec);
+    bool OpenOutput(const std::string &path);
+    void EndSegment();
+    bool StartSegment();
+    void Run();
+    void Join();
+    bool Resample(const AVFrame *frame); // 重采样写入 FIFO,nullptr 表示冲出 swr 缓存
+    void Consume(const AVFrame *frame);  // nullptr 表示冲刷
+    void EncodeFifo(bool flush);
+    void WritePackets();
+    void Fail(const char *message);
+    void CloseOutput();
+    void Cleanup();
+
+    OutputSpec spec_;
+    std::string error_;
+
+    AVCodecContext *enc_ = nullptr;
+    EncoderKey encKey_;
+    enum AVSampleFormat encSampleFmt_ = AV_SAMPLE_FMT_NONE; // 请求的编码采样格式,重新打开编码器时使用
+    const char *muxer_ = nullptr;
+    AVFormatContext *out_ = nullptr;
+    AVStream *stream_ = nullptr;
+    std::string outputPath_;
+    SwrContext *swr_ = nullptr;
+    ResampleQuality swrQuality_ = ResampleQuality::Default;
+    AVAudioFifo *fifo_ = nullptr;
+    enum AVSampleFormat fifoFormat_ = AV_SAMPLE_FMT_NONE;
+    AVFrame *resampled_ = nullptr;
+    AVFrame *encFrame_ = nullptr;
+    AVPacket *pkt_ = nullptr;
+    int sampleRate_ = 0;
+    int frameSize_ = 0;
+    bool padTail_ = false; // 编码器只接受整帧,尾部补静音
+    int64_t pts_ = 0;
+    bool headerWritten_ = false;
+    int64_t segmentSamples_ = 0;  // 每段采样数,0 表示不分段
+    bool segmentPending_ = false; // 上一段已关闭,下一段等到有数据时再打开
+    std::vector<OutputSegment> segments_;
+    std::unique_ptr<SilenceTrimmer> trimmer_; // 位于重采样和 FIFO 之间,按编码器格式判定
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<AVFrame *> queue_;
+    bool finishing_ = false;
+};
+
+// 打开输入并为最佳音频流打开解码器,其他流设为丢弃;decoderOpts 为解码器选项,可为空
+// 失败时关闭已打开的部分、写入 error 并返回 false
+bool OpenDecodeInput(const MediaInput &input, AVDictionary *decoderOpts, AVFormatContext **fmt, int *stream,
+                     AVCodecContext **dec, std::string &error);
+
+// 把 stream 全部解码并送入编码分支 (不启动线程时即在调用线程上编码);分支出错时提前停止
+// window 非空且有效时先 seek 再按采样裁剪;返回送入的采样数,sampleRate 写入解码输出的采样率
+int64_t DecodeIntoBranch(AVFormatContext *fmt, int stream, AVCodecContext *dec, EncodeBranch &branch,
+                         TimeWindow *window, int &sampleRate);
@@ -0,0 +1,362 @@
+#include "extractAudio.h"
+#include "mediaInput.h"
+#include "audioCommon.h"
+
+#include <algorithm>
+
+// 按音频编码选择可直接承载的容器,seekable 为 false 时避开需要回写文件头的容器
+static const char *PickAudioContainer(enum AVCodecID codec_id, bool seekable)
+{
+    switch (codec_id)
+    {
+    case AV_CODEC_ID_AAC:
+        return seekable ? "ipod" : "adts";
+    case AV_CODEC_ID_ALAC:
+        return "ipod";
+    case AV_CODEC_ID_MP3:
+        return "mp3";
+    case AV_CODEC_ID_VORBIS:
+    case AV_CODEC_ID_OPUS:
+    case AV_CODEC_ID_SPEEX:
+        return "ogg";
+    case AV_CODEC_ID_FLAC:
+        return "flac";
+    case AV_CODEC_ID_AMR_NB:
+    case AV_CODEC_ID_AMR_WB:
+        return "amr";
+    case AV_CODEC_ID_NTSILK_S16LE:
+        return "ntsilk_s16le";
+    case AV_CODEC_ID_PCM_S16LE:
+    case AV_CODEC_ID_PCM_S24LE:
+    case AV_CODEC_ID_PCM_S32LE:
+    case AV_CODEC_ID_PCM_F32LE:
+    case AV_CODEC_ID_PCM_U8:
+        return "wav";
+    default:
+        return nullptr;
+    }
+}
+
+// ===== ExtractAudio Async Worker =====
+class ExtractAudioWorker : public AsyncWorker
+{
+public:
+    ExtractAudioWorker(const MediaInput &input, ObjectReference &&inputRef, const std::string &outputPath, const std::string &format,
+                       const std::string &streamSpec, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), input_(input), inputRef_(std::move(inputRef)), outputPath_(outputPath), format_(format),
+          streamSpec_(streamSpec), deferred_(deferred), outData_(nullptr), outSize_(0), duration_(0), sampleRate_(0), channels_(0) {}
+
+    ~ExtractAudioWorker()
+    {
+        av_free(outData_);
+    }
+
+    void Execute() override
+    {
+        AVFormatContext *inFmt = nullptr;
+        AVFormatContext *outFmt = nullptr;
+        AVStream *inStream = nullptr;
+        AVStream *outStream = nullptr;
+        AVPacket *packet = nullptr;
+        AVPacket *silkPacket = nullptr;
+        const char *container = nullptr;
+        bool toMemory = outputPath_.empty();
+        bool headerWritten = false;
+        int audioIndex = -1;
+        int64_t lastEnd = 0;
+
+        if (OpenMediaInput(&inFmt, input_) < 0)
+        {
+            SetError("Failed to open input");
+            return;
+        }
+
+        // 选择音频流: 先按容器头信息选,尽量避免 avformat_find_stream_info 读取视频数据
+        for (unsigned int i = 0; i < inFmt->nb_streams && audioIndex < 0; i++)
+        {
+            AVStream *st = inFmt->streams[i];
+            if (streamSpec_.empty())
+            {
+                if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+                    audioIndex = (int)i;
+                continue;
+            }
+            int ret = avformat_match_stream_specifier(inFmt, st, streamSpec_.c_str());
+            if (ret < 0)
+            {
+                SetError("Invalid stream specifier: " + streamSpec_);
+                goto cleanup;
+            }
+            if (ret > 0)
+                audioIndex = (int)i;
+        }
+
+        // 其余流在解复用层丢弃,之后只读取音频数据包
+        if (audioIndex >= 0)
+        {
+            for (unsigned int i = 0; i < inFmt->nb_streams; i++)
+            {
+                if ((int)i != audioIndex)
+                    inFmt->streams[i]->discard = AVDISCARD_ALL;
+            }
+        }
+
+        // 裸流 (mp3 / adts 等) 或头信息不完整时才需要探测
+        if (audioIndex < 0 || inFmt->streams[audioIndex]->codecpar->sample_rate <= 0 ||
+            inFmt->streams[audioIndex]->codecpar->ch_layout.nb_channels <= 0)
+        {
+            if (avformat_find_stream_info(inFmt, nullptr) < 0)
+            {
+                SetError("Failed to find stream info");
+                goto cleanup;
+            }
+            if (audioIndex < 0 && streamSpec_.empty())
+            {
+                audioIndex = av_find_best_stream(inFmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+                for (unsigned int i = 0; i < inFmt->nb_streams; i++)
+                {
+                    if ((int)i != audioIndex)
+                        inFmt->streams[i]->discard = AVDISCARD_ALL;
+                }
+            }
+        }
+
+        if (audioIndex < 0)
+        {
+            SetError(streamSpec_.empty() ? "No audio stream found" : "Stream specifier matches no streams: " + streamSpec_);
+            goto cleanup;
+        }
+
+        inStream = inFmt->streams[audioIndex];
+        if (inStream->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
+        {
+            SetError("Selected stream is not an audio stream");
+            goto cleanup;
+        }
+
+        // 选择输出容器: 显式指定 > 输出文件扩展名 (能承载该编码时) > 按编码自动选择
+        if (!format_.empty())
+        {
+            container = format_.c_str();
+        }
+        else
+        {
+            const AVOutputFormat *guessed = toMemory ? nullptr : av_guess_format(nullptr, outputPath_.c_str(), nullptr);
+            if (guessed && avformat_query_codec(guessed, inStream->codecpar->codec_id, FF_COMPLIANCE_NORMAL) == 1)
+                container = guessed->name;
+            else
+                container = PickAudioContainer(inStream->codecpar->codec_id, !toMemory);
+        }
+        if (!container)
+        {
+            SetError(std::string("No container available for codec ") + avcodec_get_name(inStream->codecpar->codec_id));
+            goto cleanup;
+        }
+
+        if (avformat_alloc_output_context2(&outFmt, nullptr, container, toMemory ? nullptr : outputPath_.c_str()) < 0)
+        {
+            SetError(std::string("Failed to allocate output context for format ") + container);
+            goto cleanup;
+        }
+        if (avformat_query_codec(outFmt->oformat, inStream->codecpar->codec_id, FF_COMPLIANCE_NORMAL) == 0)
+        {
+            SetError(std::string("Codec ") + avcodec_get_name(inStream->codecpar->codec_id) +
+                     " cannot be stream-copied into format " + outFmt->oformat->name);
+            goto cleanup;
+        }
+
+        outStream = avformat_new_stream(outFmt, nullptr);
+        if (!outStream || avcodec_parameters_copy(outStream->codecpar, inStream->codecpar) < 0)
+        {
+            SetError("Failed to create output stream");
+            goto cleanup;
+        }
+        outStream->codecpar->codec_tag = 0; // 由目标容器重新选择 tag
+        outStream->time_base = inStream->time_base;
+
+        // 打开输出: 文件或内存缓冲
+        if (!(outFmt->oformat->flags & AVFMT_NOFILE))
+        {
+            int ret = toMemory ? avio_open_dyn_buf(&outFmt->pb) : avio_open(&outFmt->pb, outputPath_.c_str(), AVIO_FLAG_WRITE);
+            if (ret < 0)
+            {
+                SetError("Failed to open output");
+                goto cleanup;
+            }
+        }
+
+        if (avformat_write_header(outFmt, nullptr) < 0)
+        {
+            SetError("Failed to write header");
+            goto cleanup;
+        }
+        headerWritten = true;
+
+        // 直接复制音频数据包
+        packet = av_packet_alloc();
+        silkPacket = av_packet_alloc();
+        if (!packet || !silkPacket)
+        {
+            SetError("Failed to allocate packet");
+            goto cleanup;
+        }
+        while (av_read_frame(inFmt, packet) >= 0)
+        {
+            if (packet->stream_index == audioIndex)
+            {
+                if (packet->pts != AV_NOPTS_VALUE)
+                    lastEnd = std::max(lastEnd, av_rescale_q(packet->pts + packet->duration, inStream->time_base, AVRational{1, 1000}));
+                av_packet_rescale_ts(packet, inStream->time_base, outStream->time_base);
+                packet->stream_index = 0;
+                packet->pos = -1;
+                if (inStream->codecpar->codec_id == AV_CODEC_ID_NTSILK_S16LE)
+                {
+                    // SILK 数据包需要补回长度前缀
+                    if (SilkPacketForMuxer(packet, silkPacket) < 0)
+                    {
+                        SetError("Failed to allocate packet");
+                        goto cleanup;
+                    }
+                    av_packet_unref(packet);
+                    av_packet_move_ref(packet, silkPacket);
+                }
+                if (av_interleaved_write_frame(outFmt, packet) < 0)
+                {
+                    SetError("Failed to write packet");
+                    goto cleanup;
+                }
+            }
+            av_packet_unref(packet);
+        }
+
+        if (av_write_trailer(outFmt) < 0)
+        {
+            SetError("Failed to write trailer");
+            goto cleanup;
+        }
+
+        container_ = outFmt->oformat->name;
+        codec_ = avcodec_get_name(inStream->codecpar->codec_id);
+        sampleRate_ = inStream->codecpar->sample_rate;
+        channels_ = inStream->codecpar->ch_layout.nb_channels;
+        duration_ = lastEnd / 1000.0;
+
+    cleanup:
+        av_packet_free(&silkPacket);
+        av_packet_free(&packet);
+
+        if (outFmt)
+        {
+            if (!(outFmt->oformat->flags & AVFMT_NOFILE) && outFmt->pb)
+            {
+                if (toMemory)
+                {
+                    uint8_t *data = nullptr;
+                    int size = avio_close_dyn_buf(outFmt->pb, &data);
+                    outFmt->pb = nullptr;
+                    if (headerWritten && !outData_)
+                    {
+                        outData_ = data;
+                        outSize_ = size;
+                    }
+                    else
+                    {
+                        av_free(data);
+                    }
+                }
+                else
+                {
+                    avio_closep(&outFmt->pb);
+                }
+            }
+            avformat_free_context(outFmt);
+        }
+
+        CloseMediaInput(&inFmt);
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        Object res = Object::New(env);
+        res.Set("success", Boolean::New(env, true));
+        res.Set("format", String::New(env, container_));
+        res.Set("codec", String::New(env, codec_));
+        res.Set("sampleRate", Number::New(env, sampleRate_));
+        res.Set("channels", Number::New(env, channels_));
+        res.Set("duration", Number::New(env, duration_));
+        if (outputPath_.empty())
+        {
+            // 内存输出拷贝进 JS 自己分配的 Buffer (V8 sandbox 不允许外部内存),
+            // 原生缓冲区随后释放
+            if (outData_)
+                res.Set("data", Buffer<uint8_t>::Copy(env, outData_, outSize_));
+            else
+                res.Set("data", Buffer<uint8_t>::New(env, 0));
+            av_freep(&outData_);
+        }
+        deferred_.Resolve(res);
+    }
+
+    void OnError(const Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    MediaInput input_;
+    ObjectReference inputRef_; // Buffer 输入时保持引用
+    std::string outputPath_;
+    std::string format_;
+    std::string streamSpec_;
+    Promise::Deferred deferred_;
+    uint8_t *outData_;
+    size_t outSize_;
+    std::string container_;
+    std::string codec_;
+    double duration_;
+    int sampleRate_;
+    int channels_;
+};
+
+Value ExtractAudio(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    MediaInput input;
+    ObjectReference inputRef;
+    if (info.Length() < 1 || !GetMediaInput(info[0], input, inputRef))
+    {
+        TypeError::New(env, "Expected input (string path or Buffer)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // 第二个参数: 输出路径,null/undefined 表示输出到内存
+    std::string outputPath;
+    if (info.Length() >= 2 && !info[1].IsNull() && !info[1].IsUndefined())
+    {
+        if (!info[1].IsString())
+        {
+            TypeError::New(env, "outputPath must be a string, null or undefined").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        outputPath = info[1].As<String>().Utf8Value();
+    }
+
+    // 第三个参数可选: { format: 'ipod' | 'adts' | 'ogg' | 'flac' | ..., stream: 'a:0' }
+    std::string format;
+    std::string streamSpec;
+    if (info.Length() >= 3 && info[2].IsObject())
+    {
+        Object opts = info[2].As<Object>();
+        if (opts.Has("format") && opts.Get("format").IsString())
+            format = opts.Get("format").As<String>().Utf8Value();
+        if (opts.Has("stream") && opts.Get("stream").IsString())
+            streamSpec = opts.Get("stream").As<String>().Utf8Value();
+    }
+
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+    ExtractAudioWorker *worker = new ExtractAudioWorker(input, std::move(inputRef), outputPath, format, streamSpec, deferred);
+    worker->Queue();
+    return deferred.Promise();
+}
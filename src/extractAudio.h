@@ -0,0 +1,12 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+
+// extractAudio(input, outputPath?, options?) -> Promise
+// 从音视频文件中直接提取音频码流,不解码不重编码
+// input: 文件路径或 Buffer
+// outputPath: 输出文件路径;为 null/省略时结果中返回 Buffer
+// options.format: 输出容器 (例如 "ipod" / "adts" / "ogg" / "flac"),默认按音频编码自动选择
+// options.stream: 流说明符 (例如 "a:1"),默认选择最佳音频流
+// 非音频流在解复用层丢弃 (AVDISCARD_ALL),耗时基本等于 I/O 时间
+Value ExtractAudio(const CallbackInfo &info);
@@ -6,6 +6,14 @@
 #include "videoInfo.h"
 #include "convertNTSilk.h"
 #include "convertFile.h"
+#include "extractAudio.h"
+#include "audioSession.h"
+#include "waveform.h"
+#include "processAudio.h"
+#include "probeMany.h"
+#include "transcodeMany.h"
+#include "concatAudio.h"
+#include "storyboard.h"
 
 // Supported targets (intended to be enabled in FFmpeg build):
 // - Containers (for cover & duration): avi, matroska (mkv), mov, mp4
@@ -20,6 +28,15 @@ Object Init(Env env, Object exports)
     exports.Set("decodeAudioToFmt", Function::New(env, DecodeAudioToFmt));
     exports.Set("decodeAudioToPCM", Function::New(env, DecodeAudioToPCM));
     exports.Set("convertFile", Function::New(env, ConvertFile));
+    exports.Set("extractAudio", Function::New(env, ExtractAudio));
+    exports.Set("AudioSession", AudioSession::Init(env));
+    exports.Set("openAudio", Function::New(env, OpenAudio));
+    exports.Set("getWaveform", Function::New(env, GetWaveform));
+    exports.Set("process", Function::New(env, ProcessAudio));
+    exports.Set("probeMany", Function::New(env, ProbeMany));
+    exports.Set("transcodeMany", Function::New(env, TranscodeMany));
+    exports.Set("concat", Function::New(env, ConcatAudio));
+    exports.Set("getStoryboard", Function::New(env, GetStoryboard));
     return exports;
 }
 
@@ -0,0 +1,177 @@
+#include "framePipeline.h"
+#include <chrono>
+
+void FrameQueue::Ring::Init(size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+    slots.assign(size, nullptr);
+    mask = size - 1;
+}
+
+bool FrameQueue::Ring::TryPush(AVFrame *frame)
+{
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) > mask)
+        return false; // 满
+    slots[t & mask] = frame;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+bool FrameQueue::Ring::TryPop(AVFrame *&frame)
+{
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+        return false; // 空
+    frame = slots[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+FrameQueue::FrameQueue(int capacity, enum AVSampleFormat fmt, const AVChannelLayout *layout, int sampleRate, int nbSamples)
+    : nbSamples_(nbSamples)
+{
+    // filled_ 额外留一个位置给结束标记,两个环都不会因满而阻塞
+    filled_.Init(capacity + 1);
+    free_.Init(capacity);
+    for (int i = 0; i < capacity; i++)
+    {
+        AVFrame *frame = av_frame_alloc();
+        if (!frame)
+            return;
+        pool_.push_back(frame);
+        frame->format = fmt;
+        frame->sample_rate = sampleRate;
+        frame->nb_samples = nbSamples;
+        if (av_channel_layout_copy(&frame->ch_layout, layout) < 0 || av_frame_get_buffer(frame, 0) < 0)
+            return;
+        free_.TryPush(frame);
+    }
+    valid_ = true;
+}
+
+FrameQueue::~FrameQueue()
+{
+    for (AVFrame *frame : pool_)
+        av_frame_free(&frame);
+}
+
+// 先自旋,之后让出时间片,长时间等待时短暂休眠,避免空转占满一个核
+bool FrameQueue::Wait(Ring &ring, AVFrame *&frame)
+{
+    for (int spins = 0;; spins++)
+    {
+        if (ring.TryPop(frame))
+            return true;
+        if (aborted_.load(std::memory_order_acquire))
+            return false;
+        if (spins < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+AVFrame *FrameQueue::Acquire()
+{
+    AVFrame *frame = nullptr;
+    if (Aborted() || !Wait(free_, frame))
+        return nullptr;
+    frame->nb_samples = nbSamples_; // 上一轮可能是不足一帧的尾部
+    // 编码器可能仍持有上一轮数据的引用,此时复制出新缓冲
+    // 失败时不能把帧放回 free_ (该环只由消费者写入): 帧仍归 pool_ 所有,析构时释放;中止队列让两端都退出
+    if (av_frame_make_writable(frame) < 0)
+    {
+        Abort();
+        return nullptr;
+    }
+    return frame;
+}
+
+void FrameQueue::Push(AVFrame *frame)
+{
+    filled_.TryPush(frame);
+}
+
+AVFrame *FrameQueue::Pop()
+{
+    AVFrame *frame = nullptr;
+    if (!Wait(filled_, frame))
+        return nullptr;
+    return frame;
+}
+
+void FrameQueue::Release(AVFrame *frame)
+{
+    free_.TryPush(frame);
+}
+
+void EncodeThread::Start()
+{
+    thread_ = std::thread(&EncodeThread::Run, this);
+}
+
+void EncodeThread::Finish()
+{
+    queue_.Push(nullptr);
+    Join();
+}
+
+void EncodeThread::Join()
+{
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void EncodeThread::Run()
+{
+    AVPacket *packet = av_packet_alloc();
+    if (!packet)
+    {
+        failed_ = true;
+        queue_.Abort();
+        return;
+    }
+
+    // 第一次出错即中止队列: 生产者的 Acquire 随之返回 nullptr,不再解码剩余输入
+    auto fail = [&]()
+    {
+        failed_.store(true, std::memory_order_release);
+        queue_.Abort();
+    };
+    auto write_packets = [&]()
+    {
+        while (avcodec_receive_packet(encoder_, packet) == 0)
+        {
+            packet->stream_index = stream_->index;
+            av_packet_rescale_ts(packet, encoder_->time_base, stream_->time_base);
+            int ret = av_interleaved_write_frame(output_, packet);
+            av_packet_unref(packet);
+            if (ret < 0)
+            {
+                fail();
+                return;
+            }
+        }
+    };
+
+    AVFrame *frame;
+    while (!Failed() && (frame = queue_.Pop()) != nullptr)
+    {
+        if (avcodec_send_frame(encoder_, frame) == 0)
+            write_packets();
+        else
+            fail();
+        queue_.Release(frame);
+    }
+
+    // 冲刷编码器;出错时输出已不完整,不再冲刷
+    if (!Failed() && !queue_.Aborted())
+    {
+        avcodec_send_frame(encoder_, nullptr);
+        write_packets();
+    }
+    av_packet_free(&packet);
+}
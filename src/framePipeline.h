@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+#include <atomic>
+#include <thread>
+
+// 有界无锁单生产者/单消费者 AVFrame 队列
+// 帧在构造时一次性分配成池: 生产者 Acquire() 取空闲帧 -> 填充 -> Push();
+// 消费者 Pop() 取帧 -> 使用 -> Release() 归还。内存占用固定为 capacity 帧
+class FrameQueue
+{
+public:
+    // 池中每帧按给定参数预分配 nb_samples 个采样的缓冲
+    FrameQueue(int capacity, enum AVSampleFormat fmt, const AVChannelLayout *layout, int sampleRate, int nbSamples);
+    ~FrameQueue();
+
+    bool Valid() const { return valid_; }
+
+    // 生产者: 取一个可写的空闲帧,池空时等待;队列中止或缓冲复制失败时返回 nullptr (并中止队列)
+    AVFrame *Acquire();
+    // 生产者: 提交已填充的帧;nullptr 表示数据结束
+    void Push(AVFrame *frame);
+    // 消费者: 取下一帧,等待直到有数据;nullptr 表示数据结束或队列中止
+    AVFrame *Pop();
+    // 消费者: 归还已使用的帧
+    void Release(AVFrame *frame);
+    // 中止队列,唤醒正在等待的一方
+    void Abort() { aborted_.store(true, std::memory_order_release); }
+    bool Aborted() const { return aborted_.load(std::memory_order_acquire); }
+
+private:
+    // 单生产者/单消费者环形缓冲,容量为 2 的幂
+    struct Ring
+    {
+        std::vector<AVFrame *> slots;
+        size_t mask = 0;
+        alignas(64) std::atomic<size_t> head{0}; // 消费者读位置
+        alignas(64) std::atomic<size_t> tail{0}; // 生产者写位置
+
+        void Init(size_t capacity);
+        bool TryPush(AVFrame *frame);
+        bool TryPop(AVFrame *&frame);
+    };
+
+    bool Wait(Ring &ring, AVFrame *&frame);
+
+    Ring filled_; // 生产者 -> 消费者
+    Ring free_;   // 消费者 -> 生产者
+    std::vector<AVFrame *> pool_;
+    int nbSamples_;
+    std::atomic<bool> aborted_{false};
+    bool valid_ = false;
+};
+
+// 编码/复用阶段: 在独立线程上从 FrameQueue 取帧,编码后写入输出流
+// 调用线程负责解复用/解码/重采样,两段流水线各占一个核
+class EncodeThread
+{
+public:
+    EncodeThread(AVCodecContext *encoder, AVFormatContext *output, AVStream *stream, FrameQueue &queue)
+        : encoder_(encoder), output_(output), stream_(stream), queue_(queue) {}
+    ~EncodeThread() { Join(); }
+
+    void Start();
+    // 提交结束标记并等待编码线程冲刷编码器后退出
+    void Finish();
+    // 编码或写出是否出错;出错时编码线程中止队列并立即退出,不再编码剩余输入
+    bool Failed() const { return failed_.load(std::memory_order_acquire); }
+
+private:
+    void Run();
+    void Join();
+
+    AVCodecContext *encoder_;
+    AVFormatContext *output_;
+    AVStream *stream_;
+    FrameQueue &queue_;
+    std::thread thread_;
+    std::atomic<bool> failed_{false};
+};
@@ -0,0 +1,118 @@
+#include "mediaInput.h"
+
+#include <algorithm>
+#include <cstring>
+
+// 内存读取状态,作为自定义 AVIOContext 的 opaque
+struct MemoryReader
+{
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+};
+
+static int MemoryRead(void *opaque, uint8_t *buf, int buf_size)
+{
+    MemoryReader *reader = (MemoryReader *)opaque;
+    size_t remaining = reader->size - reader->pos;
+    if (remaining == 0)
+        return AVERROR_EOF;
+    int n = (int)std::min(remaining, (size_t)buf_size);
+    memcpy(buf, reader->data + reader->pos, n);
+    reader->pos += n;
+    return n;
+}
+
+static int64_t MemorySeek(void *opaque, int64_t offset, int whence)
+{
+    MemoryReader *reader = (MemoryReader *)opaque;
+    int64_t target;
+    switch (whence & ~AVSEEK_FORCE)
+    {
+    case AVSEEK_SIZE:
+        return (int64_t)reader->size;
+    case SEEK_SET:
+        target = offset;
+        break;
+    case SEEK_CUR:
+        target = (int64_t)reader->pos + offset;
+        break;
+    case SEEK_END:
+        target = (int64_t)reader->size + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (target < 0 || target > (int64_t)reader->size)
+        return AVERROR(EINVAL);
+    reader->pos = (size_t)target;
+    return target;
+}
+
+bool GetMediaInput(const Napi::Value &value, MediaInput &input, ObjectReference &ref)
+{
+    if (value.IsString())
+    {
+        input.path = value.As<String>().Utf8Value();
+        return true;
+    }
+    if (value.IsBuffer())
+    {
+        Buffer<uint8_t> buf = value.As<Buffer<uint8_t>>();
+        input.data = buf.Data();
+        input.size = buf.Length();
+        ref = Persistent(value.As<Object>());
+        return true;
+    }
+    return false;
+}
+
+int OpenMediaInput(AVFormatContext **fmt, const MediaInput &input)
+{
+    if (!input.data)
+    {
+        return avformat_open_input(fmt, input.path.c_str(), nullptr, nullptr);
+    }
+
+    const int io_buffer_size = 64 * 1024;
+    MemoryReader *reader = new MemoryReader{input.data, input.size, 0};
+    uint8_t *io_buffer = (uint8_t *)av_malloc(io_buffer_size);
+    AVIOContext *pb = io_buffer ? avio_alloc_context(io_buffer, io_buffer_size, 0, reader, MemoryRead, nullptr, MemorySeek) : nullptr;
+    *fmt = pb ? avformat_alloc_context() : nullptr;
+    if (!*fmt)
+    {
+        if (pb)
+            av_freep(&pb->buffer);
+        else
+            av_free(io_buffer);
+        avio_context_free(&pb);
+        delete reader;
+        return AVERROR(ENOMEM);
+    }
+    (*fmt)->pb = pb;
+    (*fmt)->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    int ret = avformat_open_input(fmt, nullptr, nullptr, nullptr);
+    if (ret < 0)
+    {
+        // 失败时 avformat_open_input 已释放 fmt,但不会释放自定义 IO
+        av_freep(&pb->buffer);
+        avio_context_free(&pb);
+        delete reader;
+    }
+    return ret;
+}
+
+void CloseMediaInput(AVFormatContext **fmt)
+{
+    if (!*fmt)
+        return;
+    AVIOContext *pb = ((*fmt)->flags & AVFMT_FLAG_CUSTOM_IO) ? (*fmt)->pb : nullptr;
+    avformat_close_input(fmt);
+    if (pb)
+    {
+        delete (MemoryReader *)pb->opaque;
+        av_freep(&pb->buffer);
+        avio_context_free(&pb);
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+
+// 输入源: 文件路径或内存中的 Buffer
+struct MediaInput
+{
+    std::string path;
+    const uint8_t *data = nullptr; // 非空时从内存读取,调用方需保证生命周期
+    size_t size = 0;
+};
+
+// 从 JS 参数解析输入源 (string 或 Buffer),失败返回 false
+// Buffer 输入时 ref 持有其引用,保证异步执行期间内存有效
+bool GetMediaInput(const Napi::Value &value, MediaInput &input, ObjectReference &ref);
+
+// 打开输入源,内存输入时挂接自定义 AVIOContext;返回值同 avformat_open_input
+int OpenMediaInput(AVFormatContext **fmt, const MediaInput &input);
+
+// 关闭由 OpenMediaInput 打开的输入,并释放自定义 AVIOContext
+void CloseMediaInput(AVFormatContext **fmt);
@@ -0,0 +1,199 @@
+#include "probeMany.h"
+#include "workStealing.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// 单个文件的探测结果
+struct ProbeResult
+{
+    double duration = NAN;
+    double bitRate = 0;
+    int sampleRate = 0;
+    int channels = 0;
+    bool hasVideo = false;
+    std::string error;
+};
+
+// 每线程的缓存状态: 打开选项只构造一次,错误信息缓冲复用
+struct ProbeScratch
+{
+    AVDictionary *openOpts = nullptr;
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+};
+
+// 容器头里的时长;没有时取各流时长的最大值
+static double ContainerDuration(const AVFormatContext *fmt)
+{
+    if (fmt->duration != AV_NOPTS_VALUE)
+        return fmt->duration / (double)AV_TIME_BASE;
+    double duration = NAN;
+    for (unsigned i = 0; i < fmt->nb_streams; ++i)
+    {
+        const AVStream *st = fmt->streams[i];
+        if (st->duration != AV_NOPTS_VALUE)
+        {
+            double d = (double)st->duration * av_q2d(st->time_base);
+            if (std::isnan(duration) || d > duration)
+                duration = d;
+        }
+    }
+    return duration;
+}
+
+// ===== ProbeMany Async Worker =====
+class ProbeManyWorker : public AsyncWorker
+{
+public:
+    ProbeManyWorker(std::vector<std::string> &&paths, int concurrency, bool fast, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), paths_(std::move(paths)), concurrency_(concurrency), fast_(fast),
+          deferred_(deferred), results_(paths_.size()) {}
+
+    void Execute() override
+    {
+        int threads = concurrency_ > 0 ? concurrency_ : (int)std::max(1u, std::thread::hardware_concurrency());
+        std::vector<ProbeScratch> scratch(std::min<size_t>(threads, paths_.size()));
+        for (ProbeScratch &s : scratch)
+        {
+            // 只看头部时限制探测量,避免 find_stream_info 读入过多数据
+            if (fast_)
+                av_dict_set_int(&s.openOpts, "probesize", 256 * 1024, 0);
+        }
+
+        RunWorkStealing(paths_.size(), threads, [&](int worker, size_t task)
+                        { Probe(scratch[worker], paths_[task], results_[task]); });
+
+        for (ProbeScratch &s : scratch)
+            av_dict_free(&s.openOpts);
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        size_t n = results_.size();
+        Float64Array duration = Float64Array::New(env, n);
+        Float64Array bitRate = Float64Array::New(env, n);
+        Int32Array sampleRate = Int32Array::New(env, n);
+        Int32Array channels = Int32Array::New(env, n);
+        Uint8Array hasVideo = Uint8Array::New(env, n);
+        Array errors = Array::New(env, n);
+        for (size_t i = 0; i < n; i++)
+        {
+            const ProbeResult &r = results_[i];
+            duration[i] = r.duration;
+            bitRate[i] = r.bitRate;
+            sampleRate[i] = r.sampleRate;
+            channels[i] = r.channels;
+            hasVideo[i] = r.hasVideo ? 1 : 0;
+            errors.Set((uint32_t)i, r.error.empty() ? env.Null() : String::New(env, r.error));
+        }
+
+        Object res = Object::New(env);
+        res.Set("duration", duration);
+        res.Set("sampleRate", sampleRate);
+        res.Set("channels", channels);
+        res.Set("bitRate", bitRate);
+        res.Set("hasVideo", hasVideo);
+        res.Set("errors", errors);
+        deferred_.Resolve(res);
+    }
+
+    void OnError(const Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    void Probe(ProbeScratch &scratch, const std::string &path, ProbeResult &result)
+    {
+        AVFormatContext *fmt = nullptr;
+        AVDictionary *opts = nullptr;
+        av_dict_copy(&opts, scratch.openOpts, 0);
+        int ret = avformat_open_input(&fmt, path.c_str(), nullptr, &opts);
+        av_dict_free(&opts);
+        if (ret < 0)
+        {
+            av_strerror(ret, scratch.errbuf, sizeof(scratch.errbuf));
+            result.error = std::string("Failed to open input: ") + scratch.errbuf;
+            return;
+        }
+
+        // fast 模式: 头部已有时长且音频参数齐全时不再读包分析
+        bool complete = fast_ && !std::isnan(ContainerDuration(fmt));
+        for (unsigned i = 0; complete && i < fmt->nb_streams; i++)
+        {
+            const AVCodecParameters *par = fmt->streams[i]->codecpar;
+            if (par->codec_type == AVMEDIA_TYPE_AUDIO && (par->sample_rate <= 0 || par->ch_layout.nb_channels <= 0))
+                complete = false;
+        }
+        if (!complete && (ret = avformat_find_stream_info(fmt, nullptr)) < 0)
+        {
+            avformat_close_input(&fmt);
+            av_strerror(ret, scratch.errbuf, sizeof(scratch.errbuf));
+            result.error = std::string("Failed to find stream info: ") + scratch.errbuf;
+            return;
+        }
+
+        result.duration = ContainerDuration(fmt);
+        result.bitRate = (double)fmt->bit_rate;
+        int audio = av_find_best_stream(fmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+        if (audio >= 0)
+        {
+            const AVCodecParameters *par = fmt->streams[audio]->codecpar;
+            result.sampleRate = par->sample_rate;
+            result.channels = par->ch_layout.nb_channels;
+        }
+        result.hasVideo = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0) >= 0;
+        avformat_close_input(&fmt);
+    }
+
+    std::vector<std::string> paths_;
+    int concurrency_;
+    bool fast_;
+    Promise::Deferred deferred_;
+    std::vector<ProbeResult> results_;
+};
+
+Value ProbeMany(const CallbackInfo &info)
+{
+    Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsArray())
+    {
+        TypeError::New(env, "Expected an array of file path strings").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Array list = info[0].As<Array>();
+    std::vector<std::string> paths;
+    paths.reserve(list.Length());
+    for (uint32_t i = 0; i < list.Length(); i++)
+    {
+        Napi::Value item = list.Get(i);
+        if (!item.IsString())
+        {
+            TypeError::New(env, "Expected an array of file path strings").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        paths.push_back(item.As<String>().Utf8Value());
+    }
+
+    int concurrency = 0;
+    bool fast = false;
+    if (info.Length() >= 2 && info[1].IsObject())
+    {
+        Object opts = info[1].As<Object>();
+        if (opts.Has("concurrency") && opts.Get("concurrency").IsNumber())
+            concurrency = opts.Get("concurrency").As<Number>().Int32Value();
+        if (opts.Has("fast") && opts.Get("fast").IsBoolean())
+            fast = opts.Get("fast").As<Boolean>().Value();
+    }
+    if (concurrency < 0 || concurrency > 256)
+    {
+        TypeError::New(env, "concurrency must be between 0 and 256").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+    ProbeManyWorker *worker = new ProbeManyWorker(std::move(paths), concurrency, fast, deferred);
+    worker->Queue();
+    return deferred.Promise();
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+
+// probeMany(paths, options?) -> Promise<{ duration, sampleRate, channels, bitRate, hasVideo, errors }>
+// 一次调用探测大量文件,结果按列返回,下标与 paths 一致:
+//   duration: Float64Array (秒,失败为 NaN)   bitRate: Float64Array (bps)
+//   sampleRate / channels: Int32Array (最佳音频流,没有音频时为 0)
+//   hasVideo: Uint8Array   errors: Array (成功为 null,失败为错误信息)
+// options.concurrency: 线程数,默认 CPU 核数;线程间按工作窃取分配文件
+// options.fast: 容器头已给出时长和音频参数时跳过 avformat_find_stream_info (与 getDuration 结果可能略有差异)
+Value ProbeMany(const CallbackInfo &info);
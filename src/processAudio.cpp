@@ -0,0 +1,213 @@
+#include "processAudio.h"
+#include "encodeBranch.h"
+#include "mediaInput.h"
+#include "waveform.h"
+#include <memory>
+#include <thread>
+
+// ===== Process Async Worker =====
+class ProcessWorker : public AsyncWorker
+{
+public:
+    ProcessWorker(const MediaInput &input, ObjectReference &&inputRef, std::vector<OutputSpec> &&specs,
+                  bool threads, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), input_(input), inputRef_(std::move(inputRef)), specs_(std::move(specs)),
+          threads_(threads), deferred_(deferred), sampleRate_(0), channels_(0), samples_(0)
+    {
+        results_.resize(specs_.size());
+    }
+
+    void Execute() override
+    {
+        AVFormatContext *fmt = nullptr;
+        AVCodecContext *dec = nullptr;
+        int stream = -1;
+        std::string error;
+        if (!OpenDecodeInput(input_, nullptr, &fmt, &stream, &dec, error))
+        {
+            SetError(error);
+            return;
+        }
+        sampleRate_ = dec->sample_rate;
+        channels_ = dec->ch_layout.nb_channels ? dec->ch_layout.nb_channels : 1;
+
+        // 建立分支: 编码分支打开失败只记录在该输出上
+        std::vector<EncodeBranch *> encoders;
+        std::vector<PeakAccumulator *> peaks;
+        for (size_t i = 0; i < specs_.size(); i++)
+        {
+            const OutputSpec &spec = specs_[i];
+            if (spec.type == "audio" || spec.type == "silk")
+            {
+                results_[i].encoder.reset(new EncodeBranch(spec));
+                if (results_[i].encoder->Open(dec))
+                    encoders.push_back(results_[i].encoder.get());
+            }
+            else if (spec.type == "waveform")
+            {
+                results_[i].peaks.reset(new PeakAccumulator(spec.buckets));
+                peaks.push_back(results_[i].peaks.get());
+            }
+        }
+
+        // 有空闲核时每个编码分支一个线程,解码线程只做分发和轻量统计
+        if (threads_ && std::thread::hardware_concurrency() > 1)
+        {
+            for (EncodeBranch *branch : encoders)
+                branch->Start();
+        }
+
+        auto dispatch = [&](const AVFrame *frame)
+        {
+            sampleRate_ = frame->sample_rate;
+            samples_ += frame->nb_samples;
+            for (PeakAccumulator *acc : peaks)
+                acc->AddFrame(frame);
+            for (EncodeBranch *branch : encoders)
+                branch->Push(frame);
+        };
+
+        AVPacket *pkt = av_packet_alloc();
+        AVFrame *frame = av_frame_alloc();
+        while (av_read_frame(fmt, pkt) >= 0)
+        {
+            if (pkt->stream_index == stream && avcodec_send_packet(dec, pkt) == 0)
+            {
+                while (avcodec_receive_frame(dec, frame) == 0)
+                {
+                    dispatch(frame);
+                    av_frame_unref(frame);
+                }
+            }
+            av_packet_unref(pkt);
+        }
+        avcodec_send_packet(dec, nullptr);
+        while (avcodec_receive_frame(dec, frame) == 0)
+        {
+            dispatch(frame);
+            av_frame_unref(frame);
+        }
+
+        for (EncodeBranch *branch : encoders)
+            branch->Finish();
+        for (OutputResult &result : results_)
+        {
+            if (result.peaks)
+                result.bucketCount = result.peaks->Finish(result.min, result.max, result.rms);
+        }
+
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        avcodec_free_context(&dec);
+        CloseMediaInput(&fmt);
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        double duration = sampleRate_ > 0 ? (double)samples_ / sampleRate_ : 0;
+        Array outputs = Array::New(env, specs_.size());
+        for (size_t i = 0; i < specs_.size(); i++)
+        {
+            const OutputSpec &spec = specs_[i];
+            OutputResult &result = results_[i];
+            Object item = Object::New(env);
+            item.Set("type", String::New(env, spec.type));
+            if (result.encoder)
+            {
+                item.Set("path", String::New(env, spec.path));
+                item.Set("success", Boolean::New(env, !result.encoder->Failed()));
+                if (result.encoder->Failed())
+                    item.Set("error", String::New(env, result.encoder->Error()));
+                else
+                    item.Set("sampleRate", Number::New(env, result.encoder->SampleRate()));
+                if (!result.encoder->Failed() && result.encoder->Trimming())
+                    item.Set("trimmed", NewTrimmedObject(env, result.encoder->TrimmedHead(), result.encoder->TrimmedTail()));
+            }
+            else if (result.peaks)
+            {
+                item.Set("buckets", Number::New(env, result.bucketCount));
+                item.Set("min", NewPeakArray(env, result.min, spec.peakFormat));
+                item.Set("max", NewPeakArray(env, result.max, spec.peakFormat));
+                item.Set("rms", NewPeakArray(env, result.rms, spec.peakFormat));
+            }
+            else
+            {
+                item.Set("duration", Number::New(env, duration));
+            }
+            outputs.Set((uint32_t)i, item);
+        }
+
+        Object res = Object::New(env);
+        res.Set("sampleRate", Number::New(env, sampleRate_));
+        res.Set("channels", Number::New(env, channels_));
+        res.Set("duration", Number::New(env, duration));
+        res.Set("outputs", outputs);
+        deferred_.Resolve(res);
+    }
+
+    void OnError(const Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    struct OutputResult
+    {
+        std::unique_ptr<EncodeBranch> encoder;
+        std::unique_ptr<PeakAccumulator> peaks;
+        int bucketCount = 0;
+        std::vector<float> min;
+        std::vector<float> max;
+        std::vector<float> rms;
+    };
+
+    MediaInput input_;
+    ObjectReference inputRef_;
+    std::vector<OutputSpec> specs_;
+    bool threads_;
+    Promise::Deferred deferred_;
+    std::vector<OutputResult> results_;
+    int sampleRate_;
+    int channels_;
+    int64_t samples_;
+};
+
+Value ProcessAudio(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    MediaInput input;
+    ObjectReference inputRef;
+    if (info.Length() < 2 || !GetMediaInput(info[0], input, inputRef) || !info[1].IsArray())
+    {
+        TypeError::New(env, "Expected input (string path or Buffer) and an outputs array").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Array list = info[1].As<Array>();
+    std::vector<OutputSpec> specs(list.Length());
+    for (uint32_t i = 0; i < list.Length(); i++)
+    {
+        if (!ParseOutputSpec(env, list.Get(i), specs[i]))
+            return env.Null();
+    }
+    if (specs.empty())
+    {
+        TypeError::New(env, "outputs must not be empty").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    bool threads = true;
+    if (info.Length() >= 3 && info[2].IsObject())
+    {
+        Object opts = info[2].As<Object>();
+        if (opts.Has("threads") && opts.Get("threads").IsBoolean())
+            threads = opts.Get("threads").As<Boolean>().Value();
+    }
+
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+    ProcessWorker *worker = new ProcessWorker(input, std::move(inputRef), std::move(specs), threads, deferred);
+    worker->Queue();
+    return deferred.Promise();
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+
+// process(input, outputs, options?) -> Promise<{ sampleRate, channels, duration, outputs }>
+// 解复用、解码只做一次,解码帧按引用分发到多个输出分支:
+//   { type: 'audio', path, format, sampleRate?, resampleQuality? }  同 decodeAudioToFmt 的格式表 (单声道)
+//   { type: 'silk', path, bitrate?, complexity?, packetSize?, dtx?, fec?, packetLoss? } NTSILK 编码
+//   编码输出都可带 trimSilence: true | { threshold, minDuration },结果项中 trimmed 为 { head, tail } 秒数
+//   { type: 'duration' }                                            按解码采样数统计的时长
+//   { type: 'waveform', buckets?, sampleFormat? }                   同 getWaveform 的 min / max / RMS
+// 每个编码分支各自持有重采样器、编码器和复用器;options.threads 为 true (默认) 且有多个核时
+// 编码分支各占一个线程,解码线程只负责分发,分析类输出在解码线程上直接累加
+// 单个编码分支失败不影响其他分支,结果中对应项带 error 字段
+Value ProcessAudio(const CallbackInfo &info);
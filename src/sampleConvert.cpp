@@ -0,0 +1,147 @@
+#include "sampleConvert.h"
+#include <cmath>
+#include <cstring>
+
+// ===== 单个采样的转换,与 swr 的 audioconvert 保持一致 =====
+
+template <typename In, typename Out>
+static inline Out ConvertSample(In v);
+
+template <>
+inline int16_t ConvertSample<int16_t, int16_t>(int16_t v) { return v; }
+template <>
+inline int32_t ConvertSample<int16_t, int32_t>(int16_t v) { return (int32_t)((uint32_t)v << 16); }
+template <>
+inline float ConvertSample<int16_t, float>(int16_t v) { return v * (1.0f / (1 << 15)); }
+
+template <>
+inline int16_t ConvertSample<int32_t, int16_t>(int32_t v) { return (int16_t)(v >> 16); }
+template <>
+inline int32_t ConvertSample<int32_t, int32_t>(int32_t v) { return v; }
+template <>
+inline float ConvertSample<int32_t, float>(int32_t v) { return v * (1.0f / (1U << 31)); }
+
+template <>
+inline int16_t ConvertSample<float, int16_t>(float v)
+{
+    // 先在 float 域内饱和,循环体没有分支便于编译器向量化
+    float s = v * (1 << 15);
+    s = s > 32767.0f ? 32767.0f : (s < -32768.0f ? -32768.0f : s);
+    return (int16_t)lrintf(s);
+}
+template <>
+inline int32_t ConvertSample<float, int32_t>(float v)
+{
+    double s = (double)v * (1U << 31);
+    s = s > 2147483647.0 ? 2147483647.0 : (s < -2147483648.0 ? -2147483648.0 : s);
+    return (int32_t)llrint(s);
+}
+template <>
+inline float ConvertSample<float, float>(float v) { return v; }
+
+// ===== 按输入/输出类型与排列实例化的转换循环 =====
+
+template <typename In, bool InPlanar, typename Out, bool OutPlanar>
+static void ConvertSamples(uint8_t *const *out, const uint8_t *const *in, int samples, int channels)
+{
+    if ((!InPlanar && !OutPlanar) || channels == 1)
+    {
+        // 两端排列相同 (或单声道): 一段连续内存的直线循环
+        int count = samples * (InPlanar ? 1 : channels);
+        int planes = InPlanar ? channels : 1;
+        for (int p = 0; p < planes; p++)
+        {
+            const In *src = (const In *)in[p];
+            Out *dst = (Out *)out[p];
+            for (int i = 0; i < count; i++)
+                dst[i] = ConvertSample<In, Out>(src[i]);
+        }
+        return;
+    }
+
+    for (int ch = 0; ch < channels; ch++)
+    {
+        const In *src = (const In *)in[InPlanar ? ch : 0] + (InPlanar ? 0 : ch);
+        Out *dst = (Out *)out[OutPlanar ? ch : 0] + (OutPlanar ? 0 : ch);
+        const int src_step = InPlanar ? 1 : channels;
+        const int dst_step = OutPlanar ? 1 : channels;
+        for (int i = 0; i < samples; i++)
+            dst[i * dst_step] = ConvertSample<In, Out>(src[i * src_step]);
+    }
+}
+
+// 格式完全相同: 每个平面一次 memcpy
+template <typename T, bool Planar>
+static void CopySamples(uint8_t *const *out, const uint8_t *const *in, int samples, int channels)
+{
+    int planes = Planar ? channels : 1;
+    size_t bytes = (size_t)samples * sizeof(T) * (Planar ? 1 : channels);
+    for (int p = 0; p < planes; p++)
+        memcpy(out[p], in[p], bytes);
+}
+
+bool IsFormatOnlyConversion(const AVChannelLayout *inLayout, int inRate, const AVChannelLayout *outLayout, int outRate)
+{
+    return inRate == outRate && av_channel_layout_compare(inLayout, outLayout) == 0;
+}
+
+// s16 / s16p / s32 / s32p / flt / fltp 在表中的下标
+static int SampleFormatIndex(enum AVSampleFormat fmt)
+{
+    switch (fmt)
+    {
+    case AV_SAMPLE_FMT_S16:
+        return 0;
+    case AV_SAMPLE_FMT_S16P:
+        return 1;
+    case AV_SAMPLE_FMT_S32:
+        return 2;
+    case AV_SAMPLE_FMT_S32P:
+        return 3;
+    case AV_SAMPLE_FMT_FLT:
+        return 4;
+    case AV_SAMPLE_FMT_FLTP:
+        return 5;
+    default:
+        return -1;
+    }
+}
+
+#define CONVERT_ROW(In, InPlanar)                                                                          \
+    {ConvertSamples<In, InPlanar, int16_t, false>, ConvertSamples<In, InPlanar, int16_t, true>,            \
+     ConvertSamples<In, InPlanar, int32_t, false>, ConvertSamples<In, InPlanar, int32_t, true>,            \
+     ConvertSamples<In, InPlanar, float, false>, ConvertSamples<In, InPlanar, float, true>}
+
+SampleConvertFn FindSampleConverter(enum AVSampleFormat inFmt, enum AVSampleFormat outFmt)
+{
+    static const SampleConvertFn table[6][6] = {
+        CONVERT_ROW(int16_t, false),
+        CONVERT_ROW(int16_t, true),
+        CONVERT_ROW(int32_t, false),
+        CONVERT_ROW(int32_t, true),
+        CONVERT_ROW(float, false),
+        CONVERT_ROW(float, true),
+    };
+
+    int in = SampleFormatIndex(inFmt);
+    int out = SampleFormatIndex(outFmt);
+    if (in < 0 || out < 0)
+        return nullptr;
+
+    if (inFmt == outFmt)
+    {
+        switch (inFmt)
+        {
+        case AV_SAMPLE_FMT_S16:
+            return CopySamples<int16_t, false>;
+        case AV_SAMPLE_FMT_S16P:
+            return CopySamples<int16_t, true>;
+        case AV_SAMPLE_FMT_S32:
+        case AV_SAMPLE_FMT_FLT:
+            return CopySamples<int32_t, false>;
+        default:
+            return CopySamples<int32_t, true>;
+        }
+    }
+    return table[in][out];
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+
+// 只改变采样格式/排列的转换函数 (采样率和声道布局相同)
+// out / in 为各平面指针,交错格式只使用 [0]
+typedef void (*SampleConvertFn)(uint8_t *const *out, const uint8_t *const *in, int samples, int channels);
+
+// 判断两端采样率与声道布局一致,只需转换采样格式
+bool IsFormatOnlyConversion(const AVChannelLayout *inLayout, int inRate, const AVChannelLayout *outLayout, int outRate);
+
+// 查找 s16/s32/flt (交错或平面) 之间的专用转换函数,不支持的组合返回 nullptr
+// 格式相同时返回按平面 memcpy 的实现
+SampleConvertFn FindSampleConverter(enum AVSampleFormat inFmt, enum AVSampleFormat outFmt);
@@ -0,0 +1,685 @@
+#include "segmentEncode.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+extern "C"
+{
+#include <libavutil/crc.h>
+#include <libavutil/intreadwrite.h>
+}
+
+static const int FLAC_STREAMINFO_SIZE = 34;
+// 每段在内存中最多积压的数据包字节数,超出后溢出到临时文件
+static const size_t SEGMENT_MEMORY_BYTES = 4 * 1024 * 1024;
+
+// 单个分段的输出: 编码线程 Push,写出线程按段的顺序 Pop
+// 正在写出的段 (一开始是第 0 段) 边编码边写出;后面的段在内存中积压到 SEGMENT_MEMORY_BYTES 后,
+// 其余数据包顺序写入临时文件,本段结束后再读回,总内存只与段数有关,与输入长度无关
+class SegmentSink
+{
+public:
+    ~SegmentSink()
+    {
+        for (AVPacket *pkt : packets_)
+            av_packet_free(&pkt);
+        if (spill_)
+        {
+            fclose(spill_);
+            std::error_code ec;
+            std::filesystem::remove(spillPath_, ec);
+        }
+    }
+
+    // 编码线程: 交出数据包的所有权;写溢出文件失败时返回 false
+    bool Push(AVPacket *pkt)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!spilling_ && bytes_ + pkt->size <= SEGMENT_MEMORY_BYTES)
+            {
+                packets_.push_back(pkt);
+                bytes_ += pkt->size;
+                cv_.notify_one();
+                return true;
+            }
+            // 开始溢出后本段之后的包都进文件,保持顺序
+            spilling_ = true;
+        }
+        // 溢出文件在本段结束前只由编码线程访问
+        bool ok = WriteSpill(pkt);
+        av_packet_free(&pkt);
+        return ok;
+    }
+
+    // 编码线程: 本段结束 (成功或出错都要调用),error / streaminfo 在此之前写好
+    void Finish()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+        cv_.notify_one();
+    }
+
+    // 写出线程: 按顺序取下一个包,必要时等待;本段结束且已取完时返回 nullptr,读溢出文件失败时写入 readError
+    AVPacket *Pop(std::string &readError)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]
+                     { return !packets_.empty() || done_; });
+            if (!packets_.empty())
+            {
+                AVPacket *pkt = packets_.front();
+                packets_.pop_front();
+                bytes_ -= pkt->size;
+                return pkt;
+            }
+        }
+        // 编码线程已结束,之后只有写出线程访问溢出文件
+        return spill_ ? ReadSpill(readError) : nullptr;
+    }
+
+    std::string error;
+    uint8_t streaminfo[FLAC_STREAMINFO_SIZE];
+    bool hasStreaminfo = false;
+
+private:
+    struct SpillHeader
+    {
+        int64_t pts;
+        int64_t dts;
+        int64_t duration;
+        int32_t flags;
+        int32_t size;
+    };
+
+    bool WriteSpill(const AVPacket *pkt)
+    {
+        if (!spill_)
+        {
+            static std::atomic<unsigned> counter{0};
+            std::error_code ec;
+            std::filesystem::path dir = std::filesystem::temp_directory_path(ec);
+            if (ec)
+                return false;
+            std::string name = "ffmpeg-addon-segment-" + std::to_string((uintptr_t)this) + "-" + std::to_string(counter++) + ".tmp";
+            spillPath_ = (dir / name).string();
+            spill_ = fopen(spillPath_.c_str(), "w+b");
+            if (!spill_)
+                return false;
+        }
+        SpillHeader header = {pkt->pts, pkt->dts, pkt->duration, pkt->flags, pkt->size};
+        return fwrite(&header, sizeof(header), 1, spill_) == 1 &&
+               (pkt->size == 0 || fwrite(pkt->data, pkt->size, 1, spill_) == 1);
+    }
+
+    AVPacket *ReadSpill(std::string &readError)
+    {
+        if (!readingSpill_)
+        {
+            rewind(spill_);
+            readingSpill_ = true;
+        }
+        SpillHeader header;
+        if (fread(&header, sizeof(header), 1, spill_) != 1)
+            return nullptr; // 文件结尾
+        AVPacket *pkt = av_packet_alloc();
+        if (!pkt || header.size < 0 || av_new_packet(pkt, header.size) < 0 ||
+            (header.size > 0 && fread(pkt->data, header.size, 1, spill_) != 1))
+        {
+            av_packet_free(&pkt);
+            readError = "Failed to read spilled segment packets";
+            return nullptr;
+        }
+        pkt->pts = header.pts;
+        pkt->dts = header.dts;
+        pkt->duration = header.duration;
+        pkt->flags = header.flags;
+        return pkt;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<AVPacket *> packets_;
+    size_t bytes_ = 0;
+    bool spilling_ = false;
+    bool done_ = false;
+    FILE *spill_ = nullptr;
+    std::string spillPath_;
+    bool readingSpill_ = false;
+};
+
+// ===== FLAC 拼接 =====
+// 各分段的 FLAC 编码器都从第 0 帧开始编号,拼接时按绝对位置重写帧头中的帧号,
+// 并重算帧头 CRC-8 与整帧 CRC-16
+
+static int FlacUtf8Length(uint8_t first)
+{
+    int len = 1;
+    if (first & 0x80)
+    {
+        len = 0;
+        while (len < 8 && (first & (0x80 >> len)))
+            len++;
+    }
+    return len;
+}
+
+static int PutFlacUtf8(uint8_t *buf, uint64_t value)
+{
+    if (value < 0x80)
+    {
+        buf[0] = (uint8_t)value;
+        return 1;
+    }
+    int len = 2;
+    while (len < 7 && value >= (1ULL << (5 * len + 1)))
+        len++;
+    for (int i = len - 1; i > 0; i--)
+    {
+        buf[i] = 0x80 | (value & 0x3F);
+        value >>= 6;
+    }
+    buf[0] = (uint8_t)((0xFF00 >> len) & 0xFF) | (uint8_t)value;
+    return len;
+}
+
+static int RenumberFlacFrame(AVPacket *pkt, uint64_t frameNumber)
+{
+    const uint8_t *src = pkt->data;
+    if (pkt->size < 8 || AV_RB16(src) != 0xFFF8) // 只处理固定块大小的帧
+        return 0;
+
+    int numLen = FlacUtf8Length(src[4]);
+    int extra = 0; // 帧号之后可选的块大小/采样率字段
+    int bsCode = src[2] >> 4;
+    int srCode = src[2] & 0x0F;
+    if (bsCode == 6)
+        extra += 1;
+    else if (bsCode == 7)
+        extra += 2;
+    if (srCode == 12)
+        extra += 1;
+    else if (srCode == 13 || srCode == 14)
+        extra += 2;
+
+    int oldHeader = 4 + numLen + extra; // 不含 CRC-8
+    int body = pkt->size - oldHeader - 1 - 2; // 去掉 CRC-8 和 CRC-16
+    if (body < 0)
+        return AVERROR_INVALIDDATA;
+
+    uint8_t number[8];
+    int newNumLen = PutFlacUtf8(number, frameNumber);
+    int newHeader = 4 + newNumLen + extra;
+    int newSize = newHeader + 1 + body + 2;
+
+    AVPacket *out = av_packet_alloc();
+    if (!out || av_new_packet(out, newSize) < 0)
+    {
+        av_packet_free(&out);
+        return AVERROR(ENOMEM);
+    }
+    uint8_t *dst = out->data;
+    memcpy(dst, src, 4);
+    memcpy(dst + 4, number, newNumLen);
+    memcpy(dst + 4 + newNumLen, src + 4 + numLen, extra);
+    dst[newHeader] = (uint8_t)av_crc(av_crc_get_table(AV_CRC_8_ATM), 0, dst, newHeader);
+    memcpy(dst + newHeader + 1, src + oldHeader + 1, body);
+    AV_WL16(dst + newSize - 2, av_crc(av_crc_get_table(AV_CRC_16_ANSI), 0, dst, newSize - 2));
+
+    av_packet_copy_props(out, pkt);
+    av_packet_unref(pkt);
+    av_packet_move_ref(pkt, out);
+    av_packet_free(&out);
+    return 0;
+}
+
+static uint64_t StreaminfoTotalSamples(const uint8_t *info)
+{
+    return ((uint64_t)(info[13] & 0x0F) << 32) | AV_RB32(info + 14);
+}
+
+// 合并各分段的 STREAMINFO: 帧大小取极值,总采样数累加;MD5 无法拼接,置 0 (规范中表示未知)
+static void MergeStreaminfo(uint8_t *merged, const uint8_t *info, bool first)
+{
+    if (first)
+    {
+        memcpy(merged, info, FLAC_STREAMINFO_SIZE);
+        return;
+    }
+    AV_WB16(merged, std::min(AV_RB16(merged), AV_RB16(info)));
+    AV_WB16(merged + 2, std::max(AV_RB16(merged + 2), AV_RB16(info + 2)));
+    uint32_t minFrame = AV_RB24(info + 4);
+    if (minFrame && (minFrame < AV_RB24(merged + 4) || AV_RB24(merged + 4) == 0))
+        AV_WB24(merged + 4, minFrame);
+    AV_WB24(merged + 7, std::max(AV_RB24(merged + 7), AV_RB24(info + 7)));
+    uint64_t total = StreaminfoTotalSamples(merged) + StreaminfoTotalSamples(info);
+    merged[13] = (merged[13] & 0xF0) | (uint8_t)((total >> 32) & 0x0F);
+    AV_WB32(merged + 14, (uint32_t)total);
+    memset(merged + 18, 0, 16);
+}
+
+// ===== 单个分段 =====
+// 输出采样位置 [start, end) 由本段编码;end < 0 表示到输入结尾
+// 数据包交给 sink,结束时总会调用 sink.Finish();cancel 置位时 (写出已出错) 尽快退出
+static void EncodeSegment(const SegmentEncodeOptions &options, AVCodecContext *mainEncoder,
+                          int64_t start, int64_t end, SegmentSink &result, const std::atomic<bool> &cancel)
+{
+    AVFormatContext *fmt = nullptr;
+    AVCodecContext *dec = nullptr;
+    AVCodecContext *enc = nullptr;
+    SwrContext *swr = nullptr;
+    AVAudioFifo *fifo = nullptr;
+    AVPacket *pkt = nullptr;
+    AVFrame *frame = nullptr;
+    AVFrame *converted = nullptr;
+    AVFrame *encFrame = nullptr;
+    AVStream *st = nullptr;
+    const AVCodec *codec = nullptr;
+    AVChannelLayout inLayout = {};
+    bool last = end < 0;
+    int rate = mainEncoder->sample_rate;
+    int frameSize = options.frameSize;
+    int64_t pos = -1;        // 下一个重采样输出采样的绝对位置
+    int64_t nextPts = start; // 下一个送入编码器的采样位置
+    bool inputDone = false;
+
+    // 按输出参数为 f 分配 nb 个采样的缓冲
+    auto allocFrame = [&](AVFrame *f, int nb) -> bool
+    {
+        av_frame_unref(f);
+        f->format = mainEncoder->sample_fmt;
+        f->sample_rate = rate;
+        f->nb_samples = nb;
+        return av_channel_layout_copy(&f->ch_layout, &mainEncoder->ch_layout) >= 0 && av_frame_get_buffer(f, 0) >= 0;
+    };
+
+    // 取出编码器产生的数据包,FLAC 的 STREAMINFO 单独保存
+    auto collect = [&]() -> bool
+    {
+        while (true)
+        {
+            AVPacket *out = av_packet_alloc();
+            if (!out)
+                return false;
+            if (avcodec_receive_packet(enc, out) < 0)
+            {
+                av_packet_free(&out);
+                return true;
+            }
+            size_t infoSize = 0;
+            const uint8_t *info = av_packet_get_side_data(out, AV_PKT_DATA_NEW_EXTRADATA, &infoSize);
+            if (info && infoSize == FLAC_STREAMINFO_SIZE)
+            {
+                memcpy(result.streaminfo, info, FLAC_STREAMINFO_SIZE);
+                result.hasStreaminfo = true;
+                av_packet_free_side_data(out);
+            }
+            if (out->size == 0)
+            {
+                av_packet_free(&out);
+                continue;
+            }
+            if (!result.Push(out))
+            {
+                result.error = "Failed to write segment spill file";
+                return false;
+            }
+        }
+    };
+
+    // 从 FIFO 按帧取样本编码;flush 时连不足一帧的尾部一起编码
+    auto encode = [&](bool flush) -> bool
+    {
+        while (av_audio_fifo_size(fifo) >= frameSize || (flush && av_audio_fifo_size(fifo) > 0))
+        {
+            if (!last && nextPts >= end)
+                return true;
+            int n = std::min(av_audio_fifo_size(fifo), frameSize);
+            if (!allocFrame(encFrame, n))
+                return false;
+            av_audio_fifo_read(fifo, (void **)encFrame->data, n);
+            encFrame->pts = nextPts;
+            nextPts += encFrame->nb_samples;
+            int ret = avcodec_send_frame(enc, encFrame);
+            av_frame_unref(encFrame);
+            if (ret < 0 || !collect())
+                return false;
+        }
+        return true;
+    };
+
+    // 重采样后按绝对位置裁掉 start 之前的样本,写入 FIFO
+    auto push = [&](AVFrame *in) -> bool
+    {
+        int inSamples = in ? in->nb_samples : 0;
+        int outSamples = (int)av_rescale_rnd(swr_get_delay(swr, dec->sample_rate) + inSamples, rate, dec->sample_rate, AV_ROUND_UP);
+        if (outSamples <= 0)
+            return true;
+        if (!allocFrame(converted, outSamples))
+            return false;
+        int n = swr_convert(swr, converted->data, outSamples, in ? (const uint8_t **)in->data : nullptr, inSamples);
+        if (n <= 0)
+            return true;
+        int64_t skip = std::min<int64_t>(std::max<int64_t>(start - pos, 0), n);
+        pos += n;
+        if (skip < n)
+        {
+            // 只有 FIFO 为空时才会出现需要跳过的开头样本,整体写入后从头丢弃即可
+            av_audio_fifo_write(fifo, (void **)converted->data, n);
+            av_audio_fifo_drain(fifo, (int)skip);
+        }
+        return encode(false);
+    };
+
+    if (avformat_open_input(&fmt, options.inputPath.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(fmt, nullptr) < 0)
+    {
+        result.error = "Failed to open input";
+        goto cleanup;
+    }
+    for (unsigned i = 0; i < fmt->nb_streams; i++)
+    {
+        if ((int)i != options.audioStream)
+            fmt->streams[i]->discard = AVDISCARD_ALL;
+    }
+    st = fmt->streams[options.audioStream];
+
+    codec = avcodec_find_decoder(st->codecpar->codec_id);
+    dec = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!dec || avcodec_parameters_to_context(dec, st->codecpar) < 0 || avcodec_open2(dec, codec, nullptr) < 0)
+    {
+        result.error = "Failed to open decoder";
+        goto cleanup;
+    }
+
+    enc = options.openEncoder();
+    if (!enc)
+    {
+        result.error = "Failed to open encoder";
+        goto cleanup;
+    }
+
+    if (dec->ch_layout.nb_channels > 0)
+        av_channel_layout_copy(&inLayout, &dec->ch_layout);
+    else
+        av_channel_layout_default(&inLayout, 1);
+    if (swr_alloc_set_opts2(&swr, &mainEncoder->ch_layout, mainEncoder->sample_fmt, rate,
+                            &inLayout, dec->sample_fmt, dec->sample_rate, 0, nullptr) < 0)
+    {
+        result.error = "Failed to initialize resampler";
+        goto cleanup;
+    }
+    ApplyResampleQuality(swr, options.resampleQuality);
+    if (swr_init(swr) < 0)
+    {
+        result.error = "Failed to initialize resampler";
+        goto cleanup;
+    }
+
+    fifo = av_audio_fifo_alloc(mainEncoder->sample_fmt, mainEncoder->ch_layout.nb_channels, frameSize * 2);
+    pkt = av_packet_alloc();
+    frame = av_frame_alloc();
+    converted = av_frame_alloc();
+    encFrame = av_frame_alloc();
+    if (!fifo || !pkt || !frame || !converted || !encFrame)
+    {
+        result.error = "Failed to allocate buffers";
+        goto cleanup;
+    }
+    // 提前 decoderPreroll 秒 seek,让解码器在本段开始前就进入稳定状态
+    if (start > 0)
+    {
+        int64_t ts = av_rescale_q(start, AVRational{1, rate}, st->time_base) -
+                     av_rescale_q((int64_t)(options.decoderPreroll * AV_TIME_BASE), AV_TIME_BASE_Q, st->time_base);
+        if (st->start_time != AV_NOPTS_VALUE)
+            ts += st->start_time;
+        if (av_seek_frame(fmt, options.audioStream, ts, AVSEEK_FLAG_BACKWARD) < 0)
+        {
+            result.error = "Failed to seek input";
+            goto cleanup;
+        }
+    }
+    else
+    {
+        pos = 0;
+    }
+
+    while (!inputDone)
+    {
+        if (cancel.load(std::memory_order_relaxed))
+        {
+            result.error = "Cancelled";
+            goto cleanup;
+        }
+        int ret = av_read_frame(fmt, pkt);
+        if (ret < 0)
+        {
+            avcodec_send_packet(dec, nullptr); // 冲刷解码器
+            inputDone = true;
+        }
+        else if (pkt->stream_index != options.audioStream)
+        {
+            av_packet_unref(pkt);
+            continue;
+        }
+        else
+        {
+            ret = avcodec_send_packet(dec, pkt);
+            av_packet_unref(pkt);
+            if (ret < 0 && ret != AVERROR(EAGAIN))
+                continue;
+        }
+
+        while (avcodec_receive_frame(dec, frame) == 0)
+        {
+            // 第一帧的时间戳确定输出采样的绝对位置
+            if (pos < 0)
+            {
+                int64_t ts = frame->best_effort_timestamp;
+                if (ts == AV_NOPTS_VALUE)
+                {
+                    result.error = "Input has no timestamps";
+                    goto cleanup;
+                }
+                if (st->start_time != AV_NOPTS_VALUE)
+                    ts -= st->start_time;
+                pos = av_rescale_q(ts, st->time_base, AVRational{1, rate});
+            }
+            bool ok = push(frame);
+            av_frame_unref(frame);
+            if (!ok)
+            {
+                if (result.error.empty())
+                    result.error = "Failed to encode segment";
+                goto cleanup;
+            }
+        }
+
+        // 非最后一段: 已覆盖到 end 就停止读取
+        if (!last && nextPts >= end)
+            break;
+    }
+
+    if (last)
+    {
+        if (!push(nullptr) || !encode(true))
+        {
+            if (result.error.empty())
+                result.error = "Failed to encode segment";
+            goto cleanup;
+        }
+    }
+
+    // 冲刷编码器 (FLAC 会在此给出本段的 STREAMINFO)
+    avcodec_send_frame(enc, nullptr);
+    if (!collect() && result.error.empty())
+        result.error = "Failed to encode segment";
+
+cleanup:
+    av_frame_free(&encFrame);
+    av_frame_free(&converted);
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    if (fifo)
+        av_audio_fifo_free(fifo);
+    swr_free(&swr);
+    av_channel_layout_uninit(&inLayout);
+    avcodec_free_context(&enc);
+    avcodec_free_context(&dec);
+    avformat_close_input(&fmt);
+    result.Finish();
+}
+
+// 检查输入能否按时间分段: 时长已知、带时间戳、可 seek,且采样率与输出相同
+// 需要重采样时各段从 seek 后第一帧的时间戳取整到输出采样点,与串行重采样的相位相差不到一个采样,
+// 拼接结果不再与串行逐采样一致,这种输入留给串行路径
+static int64_t SegmentableDuration(const SegmentEncodeOptions &options, int outputRate)
+{
+    AVFormatContext *fmt = nullptr;
+    int64_t duration = 0;
+    if (avformat_open_input(&fmt, options.inputPath.c_str(), nullptr, nullptr) < 0)
+        return 0;
+    if (avformat_find_stream_info(fmt, nullptr) >= 0 && fmt->duration > 0 &&
+        !(fmt->iformat->flags & AVFMT_NOTIMESTAMPS) && fmt->pb && (fmt->pb->seekable & AVIO_SEEKABLE_NORMAL) &&
+        options.audioStream >= 0 && options.audioStream < (int)fmt->nb_streams)
+    {
+        AVStream *st = fmt->streams[options.audioStream];
+        if (st->codecpar->sample_rate != outputRate)
+        {
+            avformat_close_input(&fmt);
+            return 0;
+        }
+        int64_t mid = av_rescale_q(fmt->duration / 2, AV_TIME_BASE_Q, st->time_base);
+        if (st->start_time != AV_NOPTS_VALUE)
+            mid += st->start_time;
+        if (av_seek_frame(fmt, options.audioStream, mid, AVSEEK_FLAG_BACKWARD) >= 0)
+            duration = fmt->duration;
+    }
+    avformat_close_input(&fmt);
+    return duration;
+}
+
+int EncodeSegmentsParallel(const SegmentEncodeOptions &options, AVCodecContext *encoder,
+                           AVFormatContext *output, AVStream *stream, std::string &error)
+{
+    if (options.segments < 2 || options.frameSize <= 0 || !options.openEncoder)
+        return 0;
+    // high 档位转 s16 时加抖动,噪声序列从每段开头重新开始,拼接结果与串行不一致
+    if (options.resampleQuality == ResampleQuality::High)
+        return 0;
+
+    int64_t duration = SegmentableDuration(options, encoder->sample_rate);
+    double seconds = duration / (double)AV_TIME_BASE;
+    int segments = std::min(options.segments, (int)(seconds / options.minSegmentSeconds));
+    if (segments < 2)
+        return 0;
+
+    // 分段边界按编码帧对齐,保证拼接后帧长一致
+    int64_t totalSamples = av_rescale(duration, encoder->sample_rate, AV_TIME_BASE);
+    int64_t frames = (totalSamples + options.frameSize - 1) / options.frameSize;
+    int64_t segmentSamples = (frames + segments - 1) / segments * options.frameSize;
+
+    // 写出线程 (调用线程) 按段的顺序取包: 第 0 段边编码边写出,后面的段在 SegmentSink 中积压或溢出到临时文件
+    std::vector<std::unique_ptr<SegmentSink>> sinks;
+    for (int i = 0; i < segments; i++)
+        sinks.emplace_back(new SegmentSink());
+    std::atomic<bool> cancel{false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < segments; i++)
+    {
+        int64_t start = i * segmentSamples;
+        int64_t end = i == segments - 1 ? -1 : start + segmentSamples;
+        threads.emplace_back(EncodeSegment, std::cref(options), encoder, start, end, std::ref(*sinks[i]), std::cref(cancel));
+    }
+
+    // 时间戳按写出的采样数连续递增;FLAC 按绝对位置重写帧号
+    bool isFlac = encoder->codec_id == AV_CODEC_ID_FLAC;
+    uint8_t streaminfo[FLAC_STREAMINFO_SIZE];
+    bool hasStreaminfo = false;
+    int64_t pts = 0;
+    int64_t frameNumber = 0;
+    auto write_packet = [&](AVPacket *pkt, bool lastPacket) -> bool
+    {
+        int64_t samples = pkt->duration > 0 ? pkt->duration : options.frameSize;
+        pkt->pts = pkt->dts = pts;
+        pkt->duration = samples;
+        pts += samples;
+        if (isFlac && RenumberFlacFrame(pkt, frameNumber++) < 0)
+        {
+            error = "Failed to stitch FLAC frames";
+            return false;
+        }
+        // 最后一个数据包带上合并后的 STREAMINFO,由 flac 复用器回写文件头
+        if (lastPacket && hasStreaminfo)
+        {
+            uint8_t *side = av_packet_new_side_data(pkt, AV_PKT_DATA_NEW_EXTRADATA, FLAC_STREAMINFO_SIZE);
+            if (side)
+                memcpy(side, streaminfo, FLAC_STREAMINFO_SIZE);
+        }
+        pkt->stream_index = stream->index;
+        av_packet_rescale_ts(pkt, encoder->time_base, stream->time_base);
+        if (av_interleaved_write_frame(output, pkt) < 0)
+        {
+            error = "Failed to write packet";
+            return false;
+        }
+        return true;
+    };
+
+    // 最后一个包要等所有段的 STREAMINFO 合并后才能写,所以总是晚一个包写出
+    AVPacket *pending = nullptr;
+    int ret = 1;
+    for (int i = 0; i < segments && ret > 0; i++)
+    {
+        SegmentSink &sink = *sinks[i];
+        std::string readError;
+        AVPacket *pkt;
+        while ((pkt = sink.Pop(readError)) != nullptr)
+        {
+            if (pending)
+            {
+                bool ok = write_packet(pending, false);
+                av_packet_free(&pending);
+                if (!ok)
+                {
+                    av_packet_free(&pkt);
+                    ret = -1;
+                    break;
+                }
+            }
+            pending = pkt;
+        }
+        if (ret < 0)
+            break;
+        // Pop 返回 nullptr 说明本段已结束,error / streaminfo 已写好
+        if (!sink.error.empty() || !readError.empty())
+        {
+            error = !sink.error.empty() ? sink.error : readError;
+            ret = -1;
+            break;
+        }
+        if (sink.hasStreaminfo)
+        {
+            MergeStreaminfo(streaminfo, sink.streaminfo, !hasStreaminfo);
+            hasStreaminfo = true;
+        }
+    }
+    if (ret > 0 && pending && !write_packet(pending, true))
+        ret = -1;
+    av_packet_free(&pending);
+
+    // 出错时通知其余分段尽快退出;未取走的包和溢出文件由 SegmentSink 析构释放
+    if (ret < 0)
+        cancel.store(true);
+    for (std::thread &t : threads)
+        t.join();
+    return ret;
+}
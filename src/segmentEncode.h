@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+#include "audioCommon.h"
+#include <functional>
+
+// 分段并行编码参数
+struct SegmentEncodeOptions
+{
+    std::string inputPath;
+    int audioStream = -1;
+    int segments = 2;              // 分段数,每段一个线程
+    int frameSize = 0;             // 编码器每帧采样数,分段边界按它对齐
+    double decoderPreroll = 0.5;   // 每段 seek 时提前的秒数,用于预热解码器
+    double minSegmentSeconds = 30; // 每段最短时长,太短的输入不分段
+    ResampleQuality resampleQuality = ResampleQuality::Default;
+    // 为每个分段打开一个与主编码器参数相同的编码器,失败返回 nullptr
+    std::function<AVCodecContext *()> openEncoder;
+};
+
+// 把输入时间轴切成若干段,每段在独立线程上 seek/解码/重采样/编码,
+// 再把各段的数据包按顺序、以连续的时间戳写入 output 的 stream
+// 第 0 段边编码边写出;后面的段每段在内存中最多积压 4MB,其余溢出到系统临时目录的文件,写出后删除
+// encoder 为已打开的主编码器,只用来读取输出参数
+// 返回 1 表示已完成;0 表示输入不适合分段 (不可 seek / 时长未知 / 太短 / 需要改变采样率 / high 重采样档位),调用方应改为串行;
+// 返回负值表示出错,原因写入 error
+int EncodeSegmentsParallel(const SegmentEncodeOptions &options, AVCodecContext *encoder,
+                           AVFormatContext *output, AVStream *stream, std::string &error);
@@ -0,0 +1,258 @@
+#include "silenceTrim.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define SILENCE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SILENCE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// ===== 平方和内核 =====
+
+static uint64_t SumSquaresS16(const int16_t *x, int n)
+{
+    uint64_t sum = 0;
+    int i = 0;
+#if defined(SILENCE_SSE2)
+    // madd 得到相邻两个平方之和 (最大 2^31,按无符号看不会溢出),再扩展到 64 位累加
+    __m128i acc = _mm_setzero_si128();
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(x + i));
+        __m128i sq = _mm_madd_epi16(v, v);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq, zero));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    sum = lanes[0] + lanes[1];
+#elif defined(SILENCE_NEON)
+    int64x2_t acc = vdupq_n_s64(0);
+    for (; i + 8 <= n; i += 8)
+    {
+        int16x8_t v = vld1q_s16(x + i);
+        acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(v), vget_low_s16(v)));
+        acc = vpadalq_s32(acc, vmull_s16(vget_high_s16(v), vget_high_s16(v)));
+    }
+    sum = (uint64_t)vaddvq_s64(acc);
+#endif
+    for (; i < n; i++)
+        sum += (uint64_t)((int32_t)x[i] * x[i]);
+    return sum;
+}
+
+static double SumSquaresFloat(const float *x, int n)
+{
+    double sum = 0;
+    int i = 0;
+#if defined(SILENCE_SSE2)
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128 a = _mm_loadu_ps(x + i);
+        __m128 b = _mm_loadu_ps(x + i + 4);
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(a, a));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(b, b));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    sum = (double)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(SILENCE_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= n; i += 8)
+    {
+        float32x4_t a = vld1q_f32(x + i);
+        float32x4_t b = vld1q_f32(x + i + 4);
+        acc0 = vfmaq_f32(acc0, a, a);
+        acc1 = vfmaq_f32(acc1, b, b);
+    }
+    sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#endif
+    for (; i < n; i++)
+        sum += (double)x[i] * x[i];
+    return sum;
+}
+
+bool ParseSilenceTrimOptions(Napi::Env env, const Napi::Value &value, SilenceTrimOptions &options)
+{
+    if (value.IsBoolean())
+    {
+        options.enabled = value.As<Boolean>().Value();
+        return true;
+    }
+    if (!value.IsObject())
+    {
+        TypeError::New(env, "trimSilence must be a boolean or { threshold, minDuration }").ThrowAsJavaScriptException();
+        return false;
+    }
+    Object opts = value.As<Object>();
+    options.enabled = true;
+    if (opts.Has("threshold") && opts.Get("threshold").IsNumber())
+        options.threshold = opts.Get("threshold").As<Number>().DoubleValue();
+    if (opts.Has("minDuration") && opts.Get("minDuration").IsNumber())
+        options.minDuration = opts.Get("minDuration").As<Number>().DoubleValue();
+    if (options.threshold > 0 || options.threshold < -120)
+    {
+        TypeError::New(env, "trimSilence.threshold must be between -120 and 0 dBFS").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (options.minDuration < 0)
+    {
+        TypeError::New(env, "trimSilence.minDuration must not be negative").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+Object NewTrimmedObject(Napi::Env env, double head, double tail)
+{
+    Object trimmed = Object::New(env);
+    trimmed.Set("head", Number::New(env, head));
+    trimmed.Set("tail", Number::New(env, tail));
+    return trimmed;
+}
+
+SilenceTrimmer::SilenceTrimmer(const SilenceTrimOptions &options, enum AVSampleFormat fmt, int sampleRate)
+    : fmt_(av_get_packed_sample_fmt(fmt)), sampleRate_(sampleRate)
+{
+    window_ = std::max(1, sampleRate / 100);
+    double linear = std::pow(10.0, options.threshold / 20.0);
+    thresholdSq_ = linear * linear;
+    minSamples_ = (int64_t)(options.minDuration * sampleRate + 0.5);
+    pending_ = av_audio_fifo_alloc(fmt_, 1, window_);
+    held_ = av_audio_fifo_alloc(fmt_, 1, window_ * 4);
+    buffer_.resize((size_t)window_ * av_get_bytes_per_sample(fmt_));
+}
+
+SilenceTrimmer::~SilenceTrimmer()
+{
+    if (pending_)
+        av_audio_fifo_free(pending_);
+    if (held_)
+        av_audio_fifo_free(held_);
+}
+
+int SilenceTrimmer::Process(const uint8_t *data, int n, AVAudioFifo *out)
+{
+    void *planes[1] = {(void *)data};
+    if (av_audio_fifo_write(pending_, planes, n) < n)
+        return AVERROR(ENOMEM);
+    while (av_audio_fifo_size(pending_) >= window_)
+    {
+        void *buf[1] = {buffer_.data()};
+        av_audio_fifo_read(pending_, buf, window_);
+        int ret = Classify(buffer_.data(), window_, out);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+int SilenceTrimmer::Finish(AVAudioFifo *out)
+{
+    int rest = av_audio_fifo_size(pending_);
+    if (rest > 0)
+    {
+        void *buf[1] = {buffer_.data()};
+        av_audio_fifo_read(pending_, buf, rest);
+        int ret = Classify(buffer_.data(), rest, out);
+        if (ret < 0)
+            return ret;
+    }
+
+    // 结尾 (或全程) 的静音: 达到 minDuration 才丢弃
+    int64_t held = av_audio_fifo_size(held_);
+    if (held > 0 && held >= minSamples_)
+    {
+        if (inHead_)
+            headTrimmed_ += held;
+        else
+            tailTrimmed_ += held;
+        av_audio_fifo_reset(held_);
+        return 0;
+    }
+    return MoveHeld(out);
+}
+
+int SilenceTrimmer::Classify(const uint8_t *data, int n, AVAudioFifo *out)
+{
+    void *planes[1] = {(void *)data};
+    if (IsSilent(data, n))
+    {
+        if (headDropping_)
+        {
+            headTrimmed_ += n;
+            return 0;
+        }
+        if (av_audio_fifo_write(held_, planes, n) < n)
+            return AVERROR(ENOMEM);
+        // 开头静音已足够长: 之前暂存的和之后的静音都丢弃
+        if (inHead_ && av_audio_fifo_size(held_) >= minSamples_)
+        {
+            headTrimmed_ += av_audio_fifo_size(held_);
+            av_audio_fifo_reset(held_);
+            headDropping_ = true;
+        }
+        return 0;
+    }
+
+    // 非静音: 暂存的 (不够长的开头静音或中间的停顿) 原样补回
+    inHead_ = false;
+    headDropping_ = false;
+    int ret = MoveHeld(out);
+    if (ret < 0)
+        return ret;
+    return av_audio_fifo_write(out, planes, n) < n ? AVERROR(ENOMEM) : 0;
+}
+
+int SilenceTrimmer::MoveHeld(AVAudioFifo *out)
+{
+    void *buf[1] = {buffer_.data()};
+    while (av_audio_fifo_size(held_) > 0)
+    {
+        int n = av_audio_fifo_read(held_, buf, window_);
+        if (n <= 0 || av_audio_fifo_write(out, buf, n) < n)
+            return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
+bool SilenceTrimmer::IsSilent(const uint8_t *data, int n) const
+{
+    double meanSq;
+    switch (fmt_)
+    {
+    case AV_SAMPLE_FMT_S16:
+        meanSq = (double)SumSquaresS16((const int16_t *)data, n) / (32768.0 * 32768.0) / n;
+        break;
+    case AV_SAMPLE_FMT_FLT:
+        meanSq = SumSquaresFloat((const float *)data, n) / n;
+        break;
+    case AV_SAMPLE_FMT_S32:
+    {
+        const int32_t *x = (const int32_t *)data;
+        double sum = 0;
+        for (int i = 0; i < n; i++)
+            sum += (double)x[i] * x[i];
+        meanSq = sum / (2147483648.0 * 2147483648.0) / n;
+        break;
+    }
+    case AV_SAMPLE_FMT_DBL:
+    {
+        const double *x = (const double *)data;
+        double sum = 0;
+        for (int i = 0; i < n; i++)
+            sum += x[i] * x[i];
+        meanSq = sum / n;
+        break;
+    }
+    default:
+        return false; // 其他格式 (u8 等) 不判定,全部保留
+    }
+    return meanSq < thresholdSq_;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+
+// 首尾静音裁剪参数
+struct SilenceTrimOptions
+{
+    bool enabled = false;
+    double threshold = -50;   // dBFS: 10ms 窗口的 RMS 低于此值视为静音
+    double minDuration = 0.3; // 秒: 首尾连续静音短于此值时保留
+};
+
+// 解析 trimSilence 选项: true / false 或 { threshold, minDuration },出错时抛出 TypeError 并返回 false
+bool ParseSilenceTrimOptions(Napi::Env env, const Napi::Value &value, SilenceTrimOptions &options);
+
+// 裁剪结果转成 { head, tail } (秒)
+Object NewTrimmedObject(Napi::Env env, double head, double tail);
+
+// 基于能量的首尾静音裁剪,放在编码器 FIFO 之前 (单声道,采样格式与编码器一致)
+// 开头: 连续静音达到 minDuration 后整段丢弃,遇到第一个非静音窗口即结束
+// 结尾: 静音窗口先暂存,之后出现非静音时原样补回;输入结束时仍是静音且达到 minDuration 则丢弃
+// 整个输入都是静音时输出为空
+class SilenceTrimmer
+{
+public:
+    SilenceTrimmer(const SilenceTrimOptions &options, enum AVSampleFormat fmt, int sampleRate);
+    ~SilenceTrimmer();
+
+    bool Valid() const { return pending_ && held_; }
+    // 送入 n 个采样,保留下来的采样写入 out;出错返回负值
+    int Process(const uint8_t *data, int n, AVAudioFifo *out);
+    // 输入结束: 处理不足一个窗口的尾部,决定结尾静音是否丢弃
+    int Finish(AVAudioFifo *out);
+
+    // 已裁掉的时长 (秒)
+    double HeadTrimmed() const { return (double)headTrimmed_ / sampleRate_; }
+    double TailTrimmed() const { return (double)tailTrimmed_ / sampleRate_; }
+
+private:
+    int Classify(const uint8_t *data, int n, AVAudioFifo *out);
+    bool IsSilent(const uint8_t *data, int n) const;
+    int MoveHeld(AVAudioFifo *out);
+
+    enum AVSampleFormat fmt_;
+    int sampleRate_;
+    int window_;          // 每个判定窗口的采样数 (10ms)
+    double thresholdSq_;  // 满幅归一化后的均方阈值
+    int64_t minSamples_;
+    AVAudioFifo *pending_ = nullptr; // 不足一个窗口的输入
+    AVAudioFifo *held_ = nullptr;    // 暂存的静音: 开头未达 minDuration 的部分,或结尾候选
+    std::vector<uint8_t> buffer_;
+    bool inHead_ = true;
+    bool headDropping_ = false; // 开头静音已达 minDuration,后续静音窗口直接丢弃
+    int64_t headTrimmed_ = 0;
+    int64_t tailTrimmed_ = 0;
+};
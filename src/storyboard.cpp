@@ -0,0 +1,434 @@
+#include "storyboard.h"
+#include "mediaInput.h"
+#include "workStealing.h"
+#include "stb_image_write.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+// 输入大于此值时默认并行 seek;小文件在一个上下文里顺序 seek 更快
+static const uintmax_t PARALLEL_SEEK_BYTES = 64 * 1024 * 1024;
+// 并行 seek 的默认线程上限: 瓶颈主要在随机读,线程再多收益不大
+static const int MAX_AUTO_THREADS = 4;
+// 每个位置最多送入的关键帧包数,解码器一直不出帧时放弃该格
+static const int MAX_KEY_PACKETS = 8;
+// 画布像素上限 (64 MP,RGB 约 192 MB),超过时拒绝而不是在工作线程里分配失败
+static const long long MAX_SHEET_PIXELS = 64LL * 1024 * 1024;
+
+struct StoryboardOptions
+{
+    int count = 16;
+    int width = 160;
+    int cols = 0; // 0 表示按 count 取接近正方形的列数
+    bool png = false;
+    int quality = 80;
+    int threads = 0; // 0 表示按输入大小决定
+};
+
+// 一个只解关键帧的解复用 + 解码上下文;并行 seek 时每个线程各持有一个
+class KeyframeReader
+{
+public:
+    ~KeyframeReader() { Close(); }
+
+    // par 为空时探测流信息并选择视频流;否则沿用主上下文的流序号和编码参数,省去 find_stream_info
+    bool Open(const MediaInput &input, int stream, const AVCodecParameters *par, std::string &error)
+    {
+        if (OpenMediaInput(&fmt_, input) < 0)
+        {
+            error = "Failed to open input";
+            return false;
+        }
+        if (!par)
+        {
+            if (avformat_find_stream_info(fmt_, nullptr) < 0)
+            {
+                error = "Failed to find stream info";
+                return false;
+            }
+            stream_ = av_find_best_stream(fmt_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+            // 音频文件里的封面图不算视频流
+            if (stream_ < 0 || (fmt_->streams[stream_]->disposition & AV_DISPOSITION_ATTACHED_PIC))
+            {
+                error = "No video stream";
+                return false;
+            }
+        }
+        else
+        {
+            stream_ = stream;
+            if (stream_ >= (int)fmt_->nb_streams)
+            {
+                error = "No video stream";
+                return false;
+            }
+        }
+        for (unsigned i = 0; i < fmt_->nb_streams; i++)
+            fmt_->streams[i]->discard = (int)i == stream_ ? AVDISCARD_NONKEY : AVDISCARD_ALL;
+
+        if (!par)
+            par = Stream()->codecpar;
+        const AVCodec *codec = avcodec_find_decoder(par->codec_id);
+        dec_ = codec ? avcodec_alloc_context3(codec) : nullptr;
+        if (!dec_ || avcodec_parameters_to_context(dec_, par) < 0)
+        {
+            error = "Decoder not found";
+            return false;
+        }
+        // 只解关键帧;帧级多线程会先缓存多帧才输出,这里只需要一帧,改用片级多线程
+        dec_->skip_frame = AVDISCARD_NONKEY;
+        dec_->thread_type = FF_THREAD_SLICE;
+        if (avcodec_open2(dec_, codec, nullptr) < 0)
+        {
+            error = "Failed to open decoder";
+            return false;
+        }
+        pkt_ = av_packet_alloc();
+        frame_ = av_frame_alloc();
+        if (!pkt_ || !frame_)
+        {
+            error = "Failed to allocate frame";
+            return false;
+        }
+        return true;
+    }
+
+    AVFormatContext *Format() const { return fmt_; }
+    AVStream *Stream() const { return fmt_->streams[stream_]; }
+    int StreamIndex() const { return stream_; }
+
+    // seek 到 ts (流时间基) 之前最近的关键帧,解出一帧缩放到 dst 指向的格子
+    // 返回该帧的时间 (秒,相对流起点),取不到帧时返回 NaN
+    double Grab(int64_t ts, uint8_t *dst, int dstStride, int tileW, int tileH)
+    {
+        avcodec_flush_buffers(dec_);
+        if (avformat_seek_file(fmt_, stream_, INT64_MIN, ts, ts, 0) < 0)
+            return NAN;
+
+        bool got = false;
+        int keyPackets = 0;
+        while (!got && keyPackets < MAX_KEY_PACKETS)
+        {
+            if (av_read_frame(fmt_, pkt_) < 0)
+            {
+                // 文件结尾: 冲出解码器里缓存的帧
+                avcodec_send_packet(dec_, nullptr);
+                got = avcodec_receive_frame(dec_, frame_) == 0;
+                break;
+            }
+            // 不支持 AVDISCARD_NONKEY 的解复用器仍会送出非关键帧,在这里跳过
+            bool key = pkt_->stream_index == stream_ && (pkt_->flags & AV_PKT_FLAG_KEY);
+            int ret = key ? avcodec_send_packet(dec_, pkt_) : AVERROR(EAGAIN);
+            av_packet_unref(pkt_);
+            if (!key)
+                continue;
+            keyPackets++;
+            if (ret == 0 || ret == AVERROR(EAGAIN))
+                got = avcodec_receive_frame(dec_, frame_) == 0;
+        }
+        if (!got)
+            return NAN;
+
+        double time = NAN;
+        sws_ = sws_getCachedContext(sws_, frame_->width, frame_->height, (AVPixelFormat)frame_->format,
+                                    tileW, tileH, AV_PIX_FMT_RGB24, SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (sws_)
+        {
+            // 目标直接是画布上的格子: 行跨度取整张画布的跨度
+            uint8_t *dst_data[4] = {dst, nullptr, nullptr, nullptr};
+            int dst_linesize[4] = {dstStride, 0, 0, 0};
+            sws_scale(sws_, frame_->data, frame_->linesize, 0, frame_->height, dst_data, dst_linesize);
+
+            AVStream *st = Stream();
+            int64_t pts = frame_->best_effort_timestamp;
+            int64_t origin = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+            time = pts != AV_NOPTS_VALUE ? (pts - origin) * av_q2d(st->time_base) : (ts - origin) * av_q2d(st->time_base);
+        }
+        av_frame_unref(frame_);
+        return time;
+    }
+
+    void Close()
+    {
+        if (sws_)
+        {
+            sws_freeContext(sws_);
+            sws_ = nullptr;
+        }
+        av_frame_free(&frame_);
+        av_packet_free(&pkt_);
+        avcodec_free_context(&dec_);
+        CloseMediaInput(&fmt_);
+    }
+
+private:
+    AVFormatContext *fmt_ = nullptr;
+    AVCodecContext *dec_ = nullptr;
+    SwsContext *sws_ = nullptr;
+    AVPacket *pkt_ = nullptr;
+    AVFrame *frame_ = nullptr;
+    int stream_ = -1;
+};
+
+static void AppendToVector(void *context, void *data, int size)
+{
+    std::vector<uint8_t> *out = (std::vector<uint8_t> *)context;
+    out->insert(out->end(), (uint8_t *)data, (uint8_t *)data + size);
+}
+
+// ===== GetStoryboard Async Worker =====
+class GetStoryboardWorker : public AsyncWorker
+{
+public:
+    GetStoryboardWorker(const MediaInput &input, ObjectReference &&inputRef, const StoryboardOptions &options,
+                        Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), input_(input), inputRef_(std::move(inputRef)), options_(options),
+          deferred_(deferred), cols_(0), rows_(0), tileHeight_(0), duration_(0), threads_(0) {}
+
+    void Execute() override
+    {
+        std::string error;
+        std::unique_ptr<KeyframeReader> main(new KeyframeReader());
+        if (!main->Open(input_, -1, nullptr, error))
+        {
+            SetError(error);
+            return;
+        }
+
+        AVFormatContext *fmt = main->Format();
+        AVStream *st = main->Stream();
+        const AVCodecParameters *par = st->codecpar;
+        if (fmt->duration != AV_NOPTS_VALUE && fmt->duration > 0)
+            duration_ = fmt->duration / (double)AV_TIME_BASE;
+        else if (st->duration != AV_NOPTS_VALUE && st->duration > 0)
+            duration_ = st->duration * av_q2d(st->time_base);
+        if (duration_ <= 0 || par->width <= 0 || par->height <= 0)
+        {
+            SetError("Failed to determine video duration or size");
+            return;
+        }
+
+        // 格子高度按显示宽高比 (考虑像素宽高比) 计算
+        AVRational sar = av_guess_sample_aspect_ratio(fmt, st, nullptr);
+        double display_width = par->width * (sar.num > 0 && sar.den > 0 ? av_q2d(sar) : 1.0);
+        tileHeight_ = std::max(1, (int)std::lround(options_.width * par->height / display_width));
+        cols_ = options_.cols > 0 ? options_.cols : (int)std::ceil(std::sqrt((double)options_.count));
+        rows_ = (options_.count + cols_ - 1) / cols_;
+        int sheet_width = cols_ * options_.width;
+        int sheet_height = rows_ * tileHeight_;
+        if (sheet_height > 65500)
+        {
+            SetError("Storyboard sheet is too tall; reduce count or width");
+            return;
+        }
+        // 参数检查按 16:9 估算格子高度,竖屏等更高的画面在这里按实际尺寸再拦一次
+        if ((long long)sheet_width * sheet_height > MAX_SHEET_PIXELS)
+        {
+            SetError("Storyboard sheet exceeds 64 megapixels; reduce count or width");
+            return;
+        }
+
+        // 画布初始化为黑色,取不到帧的格子保持黑色
+        size_t stride = (size_t)sheet_width * 3;
+        std::vector<uint8_t> canvas(stride * sheet_height, 0);
+        timestamps_.assign(options_.count, NAN);
+
+        // 每格取区间中点,避开开头的黑场和结尾之后的空 seek
+        AVRational tb = st->time_base;
+        int64_t origin = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+        std::vector<int64_t> targets(options_.count);
+        for (int i = 0; i < options_.count; i++)
+        {
+            double t = duration_ * (i + 0.5) / options_.count;
+            targets[i] = origin + av_rescale_q((int64_t)(t * AV_TIME_BASE), AV_TIME_BASE_Q, tb);
+        }
+
+        int threads = options_.threads;
+        if (threads <= 0)
+        {
+            uintmax_t size = input_.data ? input_.size : 0;
+            if (!input_.data)
+            {
+                std::error_code ec;
+                size = std::filesystem::file_size(input_.path, ec);
+                if (ec)
+                    size = 0;
+            }
+            threads = size >= PARALLEL_SEEK_BYTES
+                          ? std::min<int>(MAX_AUTO_THREADS, (int)std::max(1u, std::thread::hardware_concurrency()))
+                          : 1;
+        }
+
+        // 线程 0 (调用线程) 使用主上下文,其他线程第一次取到任务时才打开自己的上下文;
+        // 编码参数先复制一份,主上下文读包时其他线程不去碰它
+        // 每格写入画布上互不重叠的区域,线程之间无需同步
+        AVCodecParameters *shared_par = avcodec_parameters_alloc();
+        if (!shared_par || avcodec_parameters_copy(shared_par, par) < 0)
+        {
+            avcodec_parameters_free(&shared_par);
+            SetError("Failed to allocate codec parameters");
+            return;
+        }
+        int stream = main->StreamIndex();
+        std::vector<std::unique_ptr<KeyframeReader>> readers(std::min(threads, options_.count));
+        std::vector<char> open_failed(readers.size(), 0);
+        readers[0] = std::move(main);
+        auto grab = [&](int worker, size_t task)
+        {
+            if (!readers[worker] && !open_failed[worker])
+            {
+                std::string open_error;
+                readers[worker].reset(new KeyframeReader());
+                if (!readers[worker]->Open(input_, stream, shared_par, open_error))
+                {
+                    readers[worker].reset();
+                    open_failed[worker] = 1;
+                }
+            }
+            if (!readers[worker])
+                return;
+            int col = (int)task % cols_;
+            int row = (int)task / cols_;
+            uint8_t *dst = canvas.data() + (size_t)row * tileHeight_ * stride + (size_t)col * options_.width * 3;
+            timestamps_[task] = readers[worker]->Grab(targets[task], dst, (int)stride, options_.width, tileHeight_);
+        };
+        threads_ = RunWorkStealing(options_.count, threads, grab);
+        readers.clear();
+        avcodec_parameters_free(&shared_par);
+
+        int ok = options_.png
+                     ? stbi_write_png_to_func(AppendToVector, &image_, sheet_width, sheet_height, 3, canvas.data(), (int)stride)
+                     : stbi_write_jpg_to_func(AppendToVector, &image_, sheet_width, sheet_height, 3, canvas.data(), options_.quality);
+        if (!ok)
+            SetError("Failed to encode storyboard image");
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        Float64Array timestamps = Float64Array::New(env, timestamps_.size());
+        for (size_t i = 0; i < timestamps_.size(); i++)
+            timestamps[i] = timestamps_[i];
+
+        Object res = Object::New(env);
+        res.Set("image", Buffer<uint8_t>::Copy(env, image_.data(), image_.size()));
+        res.Set("format", String::New(env, options_.png ? "png" : "jpeg"));
+        res.Set("width", Number::New(env, cols_ * options_.width));
+        res.Set("height", Number::New(env, rows_ * tileHeight_));
+        res.Set("tileWidth", Number::New(env, options_.width));
+        res.Set("tileHeight", Number::New(env, tileHeight_));
+        res.Set("cols", Number::New(env, cols_));
+        res.Set("rows", Number::New(env, rows_));
+        res.Set("count", Number::New(env, options_.count));
+        res.Set("duration", Number::New(env, duration_));
+        res.Set("timestamps", timestamps);
+        res.Set("threads", Number::New(env, threads_));
+        deferred_.Resolve(res);
+    }
+
+    void OnError(const Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    MediaInput input_;
+    ObjectReference inputRef_;
+    StoryboardOptions options_;
+    Promise::Deferred deferred_;
+    std::vector<uint8_t> image_;
+    std::vector<double> timestamps_;
+    int cols_;
+    int rows_;
+    int tileHeight_;
+    double duration_;
+    int threads_;
+};
+
+Value GetStoryboard(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    MediaInput input;
+    ObjectReference inputRef;
+    if (info.Length() < 1 || !GetMediaInput(info[0], input, inputRef))
+    {
+        TypeError::New(env, "Expected input (string path or Buffer)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    StoryboardOptions options;
+    if (info.Length() >= 2 && info[1].IsObject())
+    {
+        Object opts = info[1].As<Object>();
+        if (opts.Has("count") && opts.Get("count").IsNumber())
+            options.count = opts.Get("count").As<Number>().Int32Value();
+        if (opts.Has("width") && opts.Get("width").IsNumber())
+            options.width = opts.Get("width").As<Number>().Int32Value();
+        if (opts.Has("cols") && opts.Get("cols").IsNumber())
+            options.cols = opts.Get("cols").As<Number>().Int32Value();
+        if (opts.Has("quality") && opts.Get("quality").IsNumber())
+            options.quality = opts.Get("quality").As<Number>().Int32Value();
+        if (opts.Has("threads") && opts.Get("threads").IsNumber())
+            options.threads = opts.Get("threads").As<Number>().Int32Value();
+        if (opts.Has("format") && opts.Get("format").IsString())
+        {
+            std::string format = opts.Get("format").As<String>().Utf8Value();
+            if (format == "png")
+                options.png = true;
+            else if (format != "jpeg" && format != "jpg")
+            {
+                TypeError::New(env, "Unsupported format. Supported: jpeg, png").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+        }
+    }
+    if (options.count < 1 || options.count > 1000)
+    {
+        TypeError::New(env, "count must be between 1 and 1000").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (options.width < 8 || options.width > 2048)
+    {
+        TypeError::New(env, "width must be between 8 and 2048").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (options.cols < 0 || options.cols > options.count || (long long)options.cols * options.width > 65500)
+    {
+        TypeError::New(env, "cols must be between 1 and count, and cols * width must not exceed 65500").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (options.cols == 0 && (long long)std::ceil(std::sqrt((double)options.count)) * options.width > 65500)
+    {
+        TypeError::New(env, "Storyboard sheet is too wide; reduce count or width").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    {
+        // 格子高度要打开视频才知道,这里按 16:9 估算整张画布
+        long long cols = options.cols > 0 ? options.cols : (long long)std::ceil(std::sqrt((double)options.count));
+        long long rows = (options.count + cols - 1) / cols;
+        long long tile_height = std::max(1LL, (long long)options.width * 9 / 16);
+        if (cols * options.width * rows * tile_height > MAX_SHEET_PIXELS)
+        {
+            TypeError::New(env, "Storyboard sheet exceeds 64 megapixels; reduce count or width").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+    if (options.quality < 1 || options.quality > 100)
+    {
+        TypeError::New(env, "quality must be between 1 and 100").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (options.threads < 0 || options.threads > 64)
+    {
+        TypeError::New(env, "threads must be between 0 and 64").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+    GetStoryboardWorker *worker = new GetStoryboardWorker(input, std::move(inputRef), options, deferred);
+    worker->Queue();
+    return deferred.Promise();
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+
+// getStoryboard(input, options?) -> Promise<{ image, format, width, height, tileWidth, tileHeight, cols, rows, count,
+//                                             duration, timestamps, threads }>
+// 播放器拖动预览用的雪碧图: 在 count 个等间距位置 seek,每个位置只解码其前最近的关键帧 (AVDISCARD_NONKEY),
+// swscale 直接缩放到同一张 RGB 画布的对应格子里,最后整张图只编码一次
+// options: { count = 16, width = 160 (每格宽度,高度按显示宽高比), cols (默认接近正方形),
+//            format: 'jpeg' (默认) | 'png', quality = 80 (jpeg), threads }
+// 整张画布不超过 64 MP: 参数检查按 16:9 估算,超出时抛 TypeError;按实际宽高比超出时 Promise 被拒绝
+// threads: 0 (默认) 时输入超过 64MB 才在多个解复用上下文上并行 seek;取不到帧的格子保持黑色,timestamps 中为 NaN
+// timestamps: Float64Array,每格实际使用的关键帧时间 (秒)
+Value GetStoryboard(const CallbackInfo &info);
@@ -0,0 +1,192 @@
+#include "transcodeMany.h"
+#include "encodeBranch.h"
+#include "workStealing.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <thread>
+
+// 单个转码任务
+struct TranscodeJob
+{
+    std::string input;
+    OutputSpec output;
+};
+
+struct TranscodeResult
+{
+    std::string error;
+    double duration = 0;
+    int sampleRate = 0;
+    bool trimmed = false;
+    double trimmedHead = 0;
+    double trimmedTail = 0;
+};
+
+// ===== TranscodeMany Async Worker =====
+class TranscodeManyWorker : public AsyncWorker
+{
+public:
+    TranscodeManyWorker(std::vector<TranscodeJob> &&jobs, int concurrency, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), jobs_(std::move(jobs)), concurrency_(concurrency), deferred_(deferred),
+          results_(jobs_.size()), threads_(0), elapsed_(0), totalBytes_(0) {}
+
+    void Execute() override
+    {
+        // 大文件先做,尾部只剩小任务时各线程更容易均衡
+        std::vector<uintmax_t> sizes(jobs_.size(), 0);
+        for (size_t i = 0; i < jobs_.size(); i++)
+        {
+            std::error_code ec;
+            uintmax_t size = std::filesystem::file_size(jobs_[i].input, ec);
+            sizes[i] = ec ? 0 : size;
+            totalBytes_ += sizes[i];
+        }
+        std::vector<size_t> order(jobs_.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                         { return sizes[a] > sizes[b]; });
+
+        int threads = concurrency_ > 0 ? concurrency_ : (int)std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::unique_ptr<EncodeBranch>> branches(std::min<size_t>(threads, jobs_.size()));
+        for (std::unique_ptr<EncodeBranch> &branch : branches)
+            branch.reset(new EncodeBranch());
+
+        auto start = std::chrono::steady_clock::now();
+        threads_ = RunWorkStealing(jobs_.size(), threads, [&](int worker, size_t task)
+                                   { Transcode(*branches[worker], jobs_[task], results_[task]); },
+                                   order);
+        elapsed_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        Array jobs = Array::New(env, jobs_.size());
+        double total_duration = 0;
+        for (size_t i = 0; i < jobs_.size(); i++)
+        {
+            const TranscodeResult &r = results_[i];
+            Object item = Object::New(env);
+            item.Set("input", String::New(env, jobs_[i].input));
+            item.Set("path", String::New(env, jobs_[i].output.path));
+            item.Set("success", Boolean::New(env, r.error.empty()));
+            if (!r.error.empty())
+            {
+                item.Set("error", String::New(env, r.error));
+            }
+            else
+            {
+                item.Set("duration", Number::New(env, r.duration));
+                item.Set("sampleRate", Number::New(env, r.sampleRate));
+                if (r.trimmed)
+                    item.Set("trimmed", NewTrimmedObject(env, r.trimmedHead, r.trimmedTail));
+                total_duration += r.duration;
+            }
+            jobs.Set((uint32_t)i, item);
+        }
+
+        Object res = Object::New(env);
+        res.Set("jobs", jobs);
+        res.Set("threads", Number::New(env, threads_));
+        res.Set("elapsed", Number::New(env, elapsed_));
+        res.Set("totalDuration", Number::New(env, total_duration));
+        res.Set("speed", Number::New(env, elapsed_ > 0 ? total_duration / elapsed_ : 0));
+        res.Set("totalBytes", Number::New(env, (double)totalBytes_));
+        deferred_.Resolve(res);
+    }
+
+    void OnError(const Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    // 在当前线程上完成一个任务: 解码后直接送入该线程的编码分支
+    static void Transcode(EncodeBranch &branch, const TranscodeJob &job, TranscodeResult &result)
+    {
+        MediaInput input;
+        input.path = job.input;
+        AVFormatContext *fmt = nullptr;
+        AVCodecContext *dec = nullptr;
+        int stream = -1;
+        if (!OpenDecodeInput(input, nullptr, &fmt, &stream, &dec, result.error))
+            return;
+
+        branch.Reset(job.output);
+        int64_t samples = 0;
+        int sample_rate = dec->sample_rate;
+        if (branch.Open(dec))
+            samples = DecodeIntoBranch(fmt, stream, dec, branch, nullptr, sample_rate);
+        // Open 失败时 Finish 只关闭已创建的输出文件
+        branch.Finish();
+
+        result.error = branch.Error();
+        result.sampleRate = branch.SampleRate();
+        result.trimmed = branch.Trimming();
+        result.trimmedHead = branch.TrimmedHead();
+        result.trimmedTail = branch.TrimmedTail();
+        result.duration = sample_rate > 0 ? (double)samples / sample_rate : 0;
+
+        avcodec_free_context(&dec);
+        CloseMediaInput(&fmt);
+    }
+
+    std::vector<TranscodeJob> jobs_;
+    int concurrency_;
+    Promise::Deferred deferred_;
+    std::vector<TranscodeResult> results_;
+    int threads_;
+    double elapsed_;
+    uintmax_t totalBytes_;
+};
+
+Value TranscodeMany(const CallbackInfo &info)
+{
+    Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsArray())
+    {
+        TypeError::New(env, "Expected an array of jobs").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Array list = info[0].As<Array>();
+    std::vector<TranscodeJob> jobs(list.Length());
+    for (uint32_t i = 0; i < list.Length(); i++)
+    {
+        Napi::Value item = list.Get(i);
+        if (!item.IsObject() || !item.As<Object>().Get("input").IsString())
+        {
+            TypeError::New(env, "Each job must be an object with an input path string").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        jobs[i].input = item.As<Object>().Get("input").As<String>().Utf8Value();
+        if (!ParseOutputSpec(env, item, jobs[i].output))
+            return env.Null();
+        if (jobs[i].output.type != "audio" && jobs[i].output.type != "silk")
+        {
+            TypeError::New(env, "Job type must be 'audio' or 'silk'").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    int concurrency = 0;
+    if (info.Length() >= 2 && info[1].IsObject())
+    {
+        Object opts = info[1].As<Object>();
+        if (opts.Has("concurrency") && opts.Get("concurrency").IsNumber())
+            concurrency = opts.Get("concurrency").As<Number>().Int32Value();
+    }
+    if (concurrency < 0 || concurrency > 256)
+    {
+        TypeError::New(env, "concurrency must be between 0 and 256").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+    TranscodeManyWorker *worker = new TranscodeManyWorker(std::move(jobs), concurrency, deferred);
+    worker->Queue();
+    return deferred.Promise();
+}
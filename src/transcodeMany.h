@@ -0,0 +1,11 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+
+// transcodeMany(jobs, options?) -> Promise<{ jobs, threads, elapsed, totalDuration, speed, totalBytes }>
+// jobs: [{ input, type: 'audio' | 'silk', path, ... }],输出参数同 process() 的编码输出项
+// options.concurrency: 线程数,默认 CPU 核数
+// 所有任务在一个 AsyncWorker 内由原生线程池执行: 按输入文件大小从大到小分配,空闲线程从其他线程偷任务;
+// 每个线程持有一个编码分支,相邻任务复用其中的重采样器和缓冲,编码器按任务重新打开
+// 单个任务失败不影响其他任务,对应项 success 为 false 并带 error
+Value TranscodeMany(const CallbackInfo &info);
@@ -0,0 +1,406 @@
+#include "waveform.h"
+#include "audioCommon.h"
+#include "mediaInput.h"
+#include "sampleConvert.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define WAVEFORM_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define WAVEFORM_NEON 1
+#include <arm_neon.h>
+#endif
+
+// 最多保留 桶数 x BLOCKS_PER_BUCKET 个块,合并到桶时每桶 8~16 块,各桶宽度相差不超过 1/8
+static const int BLOCKS_PER_BUCKET = 16;
+
+// ===== min / max / 平方和归约内核 =====
+
+static void ReduceFloat(const float *x, int n, float &mn, float &mx, double &sumsq)
+{
+    int i = 0;
+#if defined(WAVEFORM_SSE2)
+    if (n >= 8)
+    {
+        __m128 vmin = _mm_set1_ps(mn), vmax = _mm_set1_ps(mx);
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128 a = _mm_loadu_ps(x + i);
+            __m128 b = _mm_loadu_ps(x + i + 4);
+            vmin = _mm_min_ps(vmin, _mm_min_ps(a, b));
+            vmax = _mm_max_ps(vmax, _mm_max_ps(a, b));
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(a, a));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(b, b));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, vmin);
+        mn = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+        _mm_storeu_ps(lanes, vmax);
+        mx = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+        _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+        sumsq += (double)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+#elif defined(WAVEFORM_NEON)
+    if (n >= 8)
+    {
+        float32x4_t vmin = vdupq_n_f32(mn), vmax = vdupq_n_f32(mx);
+        float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+        for (; i + 8 <= n; i += 8)
+        {
+            float32x4_t a = vld1q_f32(x + i);
+            float32x4_t b = vld1q_f32(x + i + 4);
+            vmin = vminq_f32(vmin, vminq_f32(a, b));
+            vmax = vmaxq_f32(vmax, vmaxq_f32(a, b));
+            acc0 = vfmaq_f32(acc0, a, a);
+            acc1 = vfmaq_f32(acc1, b, b);
+        }
+        mn = vminvq_f32(vmin);
+        mx = vmaxvq_f32(vmax);
+        sumsq += vaddvq_f32(vaddq_f32(acc0, acc1));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        mn = std::min(mn, x[i]);
+        mx = std::max(mx, x[i]);
+        sumsq += (double)x[i] * x[i];
+    }
+}
+
+// ===== PeakAccumulator =====
+
+PeakAccumulator::PeakAccumulator(int buckets) : buckets_(std::max(buckets, 1))
+{
+    current_ = {FLT_MAX, -FLT_MAX, 0.0, 0};
+    blocks_.reserve((size_t)buckets_ * BLOCKS_PER_BUCKET);
+}
+
+void PeakAccumulator::CompleteBlock()
+{
+    blocks_.push_back(current_);
+    current_ = {FLT_MAX, -FLT_MAX, 0.0, 0};
+    blockFill_ = 0;
+
+    // 块数到达上限: 两两合并,块长加倍
+    if (blocks_.size() >= (size_t)buckets_ * BLOCKS_PER_BUCKET)
+    {
+        size_t half = blocks_.size() / 2;
+        for (size_t i = 0; i < half; i++)
+        {
+            const Block &a = blocks_[2 * i];
+            const Block &b = blocks_[2 * i + 1];
+            blocks_[i] = {std::min(a.min, b.min), std::max(a.max, b.max), a.sumsq + b.sumsq, a.count + b.count};
+        }
+        blocks_.resize(half);
+        blockSize_ *= 2;
+    }
+}
+
+// planes 为 float 数据;交错格式 planeCount = 1 且 stride = 声道数,平面格式 stride = 1
+void PeakAccumulator::AddFloat(const float *const *planes, int planeCount, int stride, int nbSamples)
+{
+    int offset = 0;
+    while (offset < nbSamples)
+    {
+        int span = (int)std::min<int64_t>(nbSamples - offset, blockSize_ - blockFill_);
+        for (int p = 0; p < planeCount; p++)
+            ReduceFloat(planes[p] + (size_t)offset * stride, span * stride, current_.min, current_.max, current_.sumsq);
+        current_.count += (int64_t)span * stride * planeCount;
+        blockFill_ += span;
+        offset += span;
+        if (blockFill_ == blockSize_)
+            CompleteBlock();
+    }
+}
+
+void PeakAccumulator::AddFrame(const AVFrame *frame)
+{
+    int nb_samples = frame->nb_samples;
+    if (nb_samples <= 0)
+        return;
+    enum AVSampleFormat fmt = (enum AVSampleFormat)frame->format;
+    int channels = frame->ch_layout.nb_channels > 0 ? frame->ch_layout.nb_channels : 1;
+    bool planar = av_sample_fmt_is_planar(fmt);
+    int plane_count = planar ? channels : 1;
+    int stride = planar ? 1 : channels;
+    samples_ += nb_samples;
+
+    // 平面数超过 AV_NUM_DATA_POINTERS 时 data 放在 extended_data
+    std::vector<const float *> planes(plane_count);
+    enum AVSampleFormat packed = av_get_packed_sample_fmt(fmt);
+    if (packed == AV_SAMPLE_FMT_FLT)
+    {
+        for (int p = 0; p < plane_count; p++)
+            planes[p] = (const float *)frame->extended_data[p];
+        AddFloat(planes.data(), plane_count, stride, nb_samples);
+        return;
+    }
+
+    // 其他格式先转换为同排列的 float
+    size_t plane_len = (size_t)nb_samples * stride;
+    scratch_.resize(plane_len * plane_count);
+    SampleConvertFn convert = FindSampleConverter(fmt, planar ? AV_SAMPLE_FMT_FLTP : AV_SAMPLE_FMT_FLT);
+    if (convert && plane_count <= AV_NUM_DATA_POINTERS)
+    {
+        uint8_t *dst[AV_NUM_DATA_POINTERS] = {nullptr};
+        for (int p = 0; p < plane_count; p++)
+            dst[p] = (uint8_t *)(scratch_.data() + p * plane_len);
+        convert(dst, (const uint8_t *const *)frame->extended_data, nb_samples, channels);
+    }
+    else
+    {
+        for (int p = 0; p < plane_count; p++)
+        {
+            float *dst = scratch_.data() + p * plane_len;
+            const uint8_t *src = frame->extended_data[p];
+            for (size_t i = 0; i < plane_len; i++)
+            {
+                switch (packed)
+                {
+                case AV_SAMPLE_FMT_U8:
+                    dst[i] = (src[i] - 128) * (1.0f / 128);
+                    break;
+                case AV_SAMPLE_FMT_S16:
+                    dst[i] = ((const int16_t *)src)[i] * (1.0f / (1 << 15));
+                    break;
+                case AV_SAMPLE_FMT_S32:
+                    dst[i] = ((const int32_t *)src)[i] * (1.0f / (1U << 31));
+                    break;
+                case AV_SAMPLE_FMT_DBL:
+                    dst[i] = (float)((const double *)src)[i];
+                    break;
+                case AV_SAMPLE_FMT_S64:
+                    dst[i] = (float)(((const int64_t *)src)[i] * (1.0 / 9223372036854775808.0));
+                    break;
+                default:
+                    dst[i] = 0.0f;
+                    break;
+                }
+            }
+        }
+    }
+    for (int p = 0; p < plane_count; p++)
+        planes[p] = scratch_.data() + p * plane_len;
+    AddFloat(planes.data(), plane_count, stride, nb_samples);
+}
+
+int PeakAccumulator::Finish(std::vector<float> &min, std::vector<float> &max, std::vector<float> &rms)
+{
+    if (blockFill_ > 0)
+    {
+        blocks_.push_back(current_);
+        current_ = {FLT_MAX, -FLT_MAX, 0.0, 0};
+        blockFill_ = 0;
+    }
+
+    // 块数多于桶数时每桶合并 BLOCKS_PER_BUCKET/2 ~ BLOCKS_PER_BUCKET 个块
+    size_t block_count = blocks_.size();
+    int buckets = (int)std::min<size_t>(buckets_, block_count);
+    min.assign(buckets, 0.0f);
+    max.assign(buckets, 0.0f);
+    rms.assign(buckets, 0.0f);
+    for (int b = 0; b < buckets; b++)
+    {
+        size_t first = block_count * b / buckets;
+        size_t last = block_count * (b + 1) / buckets;
+        Block acc = {FLT_MAX, -FLT_MAX, 0.0, 0};
+        for (size_t i = first; i < last; i++)
+        {
+            acc.min = std::min(acc.min, blocks_[i].min);
+            acc.max = std::max(acc.max, blocks_[i].max);
+            acc.sumsq += blocks_[i].sumsq;
+            acc.count += blocks_[i].count;
+        }
+        min[b] = acc.count > 0 ? acc.min : 0.0f;
+        max[b] = acc.count > 0 ? acc.max : 0.0f;
+        rms[b] = acc.count > 0 ? (float)std::sqrt(acc.sumsq / acc.count) : 0.0f;
+    }
+    return buckets;
+}
+
+Value NewPeakArray(Napi::Env env, const std::vector<float> &values, enum AVSampleFormat fmt)
+{
+    std::vector<uint8_t> data(values.size() * av_get_bytes_per_sample(fmt));
+    if (fmt == AV_SAMPLE_FMT_S16)
+    {
+        int16_t *dst = (int16_t *)data.data();
+        for (size_t i = 0; i < values.size(); i++)
+            dst[i] = (int16_t)std::lrint(std::max(-1.0f, std::min(1.0f, values[i])) * 32767.0f);
+    }
+    else if (!values.empty())
+    {
+        memcpy(data.data(), values.data(), data.size());
+    }
+    return NewPcmTypedArray(env, std::move(data), fmt);
+}
+
+// ===== GetWaveform Async Worker =====
+class GetWaveformWorker : public AsyncWorker
+{
+public:
+    GetWaveformWorker(const MediaInput &input, ObjectReference &&inputRef, int buckets, enum AVSampleFormat sampleFormat, Promise::Deferred deferred)
+        : AsyncWorker(deferred.Env()), input_(input), inputRef_(std::move(inputRef)), sampleFormat_(sampleFormat),
+          deferred_(deferred), accumulator_(buckets), sampleRate_(0), bucketCount_(0) {}
+
+    void Execute() override
+    {
+        AVFormatContext *fmt = nullptr;
+        if (OpenMediaInput(&fmt, input_) < 0)
+        {
+            SetError("Failed to open input");
+            return;
+        }
+        if (avformat_find_stream_info(fmt, nullptr) < 0)
+        {
+            CloseMediaInput(&fmt);
+            SetError("Failed to find stream info");
+            return;
+        }
+        int stream = av_find_best_stream(fmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+        if (stream < 0)
+        {
+            CloseMediaInput(&fmt);
+            SetError("No audio stream");
+            return;
+        }
+        for (unsigned i = 0; i < fmt->nb_streams; i++)
+        {
+            if ((int)i != stream)
+                fmt->streams[i]->discard = AVDISCARD_ALL;
+        }
+
+        AVStream *st = fmt->streams[stream];
+        const AVCodec *codec = avcodec_find_decoder(st->codecpar->codec_id);
+        if (!codec)
+        {
+            CloseMediaInput(&fmt);
+            SetError("Decoder not found");
+            return;
+        }
+
+        // SILK 输入: 解码器直接输出 8kHz,波形不需要更高的采样率
+        AVDictionary *dec_opts = nullptr;
+        if (st->codecpar->codec_id == AV_CODEC_ID_NTSILK_S16LE)
+            av_dict_set_int(&dec_opts, "api_sample_rate", 8000, 0);
+
+        AVCodecContext *dec = avcodec_alloc_context3(codec);
+        avcodec_parameters_to_context(dec, st->codecpar);
+        if (avcodec_open2(dec, codec, &dec_opts) < 0)
+        {
+            av_dict_free(&dec_opts);
+            avcodec_free_context(&dec);
+            CloseMediaInput(&fmt);
+            SetError("Failed to open decoder");
+            return;
+        }
+        av_dict_free(&dec_opts);
+
+        // 解码循环中直接归约,每帧处理完即释放
+        AVPacket *pkt = av_packet_alloc();
+        AVFrame *frame = av_frame_alloc();
+        while (av_read_frame(fmt, pkt) >= 0)
+        {
+            if (pkt->stream_index == stream && avcodec_send_packet(dec, pkt) == 0)
+            {
+                while (avcodec_receive_frame(dec, frame) == 0)
+                {
+                    sampleRate_ = frame->sample_rate;
+                    accumulator_.AddFrame(frame);
+                }
+            }
+            av_packet_unref(pkt);
+        }
+        avcodec_send_packet(dec, nullptr);
+        while (avcodec_receive_frame(dec, frame) == 0)
+        {
+            sampleRate_ = frame->sample_rate;
+            accumulator_.AddFrame(frame);
+        }
+
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        avcodec_free_context(&dec);
+        CloseMediaInput(&fmt);
+
+        bucketCount_ = accumulator_.Finish(min_, max_, rms_);
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        Object res = Object::New(env);
+        res.Set("buckets", Number::New(env, bucketCount_));
+        res.Set("sampleRate", Number::New(env, sampleRate_));
+        res.Set("duration", Number::New(env, sampleRate_ > 0 ? (double)accumulator_.Samples() / sampleRate_ : 0));
+        res.Set("min", NewPeakArray(env, min_, sampleFormat_));
+        res.Set("max", NewPeakArray(env, max_, sampleFormat_));
+        res.Set("rms", NewPeakArray(env, rms_, sampleFormat_));
+        deferred_.Resolve(res);
+    }
+
+    void OnError(const Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    MediaInput input_;
+    ObjectReference inputRef_;
+    enum AVSampleFormat sampleFormat_;
+    Promise::Deferred deferred_;
+    PeakAccumulator accumulator_;
+    int sampleRate_;
+    int bucketCount_;
+    std::vector<float> min_;
+    std::vector<float> max_;
+    std::vector<float> rms_;
+};
+
+Value GetWaveform(const CallbackInfo &info)
+{
+    Env env = info.Env();
+
+    MediaInput input;
+    ObjectReference inputRef;
+    if (info.Length() < 1 || !GetMediaInput(info[0], input, inputRef))
+    {
+        TypeError::New(env, "Expected input (string path or Buffer)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int buckets = 1000;
+    enum AVSampleFormat sampleFormat = AV_SAMPLE_FMT_FLT;
+    if (info.Length() >= 2 && info[1].IsObject())
+    {
+        Object opts = info[1].As<Object>();
+        if (opts.Has("buckets") && opts.Get("buckets").IsNumber())
+            buckets = opts.Get("buckets").As<Number>().Int32Value();
+        if (opts.Has("sampleFormat") && opts.Get("sampleFormat").IsString())
+        {
+            std::string name = opts.Get("sampleFormat").As<String>().Utf8Value();
+            if (name == "s16")
+                sampleFormat = AV_SAMPLE_FMT_S16;
+            else if (name != "f32")
+            {
+                TypeError::New(env, "Unsupported sampleFormat. Supported: s16, f32").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+        }
+    }
+    if (buckets < 1 || buckets > 1000000)
+    {
+        TypeError::New(env, "buckets must be between 1 and 1000000").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+    GetWaveformWorker *worker = new GetWaveformWorker(input, std::move(inputRef), buckets, sampleFormat, deferred);
+    worker->Queue();
+    return deferred.Promise();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ffmpegCommon.h"
+
+// 流式波形统计: 解码循环中逐帧累加,最终输出固定桶数的 min / max / RMS
+// 内部按块累加,块数超过上限时两两合并并把块长加倍,内存与输入长度无关
+// 多声道合并统计 (min / max 取所有声道的极值,RMS 为所有声道的均方根)
+class PeakAccumulator
+{
+public:
+    explicit PeakAccumulator(int buckets);
+
+    // 累加一帧解码输出,支持所有常见采样格式 (交错或平面)
+    void AddFrame(const AVFrame *frame);
+    // 结束统计并合并到桶;输入采样数少于桶数时桶数随之减少,返回实际桶数
+    int Finish(std::vector<float> &min, std::vector<float> &max, std::vector<float> &rms);
+    // 已累加的采样数 (每声道)
+    int64_t Samples() const { return samples_; }
+
+private:
+    struct Block
+    {
+        float min;
+        float max;
+        double sumsq;
+        int64_t count; // 值的个数 (采样数 x 声道数)
+    };
+
+    void AddFloat(const float *const *planes, int planeCount, int stride, int nbSamples);
+    void CompleteBlock();
+
+    int buckets_;
+    int64_t blockSize_ = 1; // 每块的采样数 (每声道)
+    int64_t blockFill_ = 0;
+    Block current_;
+    std::vector<Block> blocks_;
+    std::vector<float> scratch_;
+    int64_t samples_ = 0;
+};
+
+// 按 fmt 生成 Float32Array 或 Int16Array (满幅 32767)
+Value NewPeakArray(Napi::Env env, const std::vector<float> &values, enum AVSampleFormat fmt);
+
+// getWaveform(input, options?) -> Promise<{ buckets, sampleRate, duration, min, max, rms }>
+// input: 文件路径或 Buffer
+// options.buckets: 桶数,默认 1000
+// options.sampleFormat: 's16' 返回 Int16Array,'f32' (默认) 返回 Float32Array
+// 只保留固定大小的统计结果,不会生成完整 PCM
+Value GetWaveform(const CallbackInfo &info);
@@ -0,0 +1,79 @@
+#include "workStealing.h"
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+// 每线程一个任务队列;任务只在开始前放入,运行中只取不放,锁的竞争只发生在偷任务时
+class TaskDeque
+{
+public:
+    void Push(size_t task) { tasks_.push_back(task); }
+
+    bool PopFront(size_t &task)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty())
+            return false;
+        task = tasks_.front();
+        tasks_.pop_front();
+        return true;
+    }
+
+    bool StealBack(size_t &task)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty())
+            return false;
+        task = tasks_.back();
+        tasks_.pop_back();
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<size_t> tasks_;
+};
+}
+
+int RunWorkStealing(size_t count, int threads, const std::function<void(int worker, size_t task)> &fn,
+                    const std::vector<size_t> &order)
+{
+    if (count == 0)
+        return 0;
+    if (threads <= 0)
+        threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    threads = (int)std::min<size_t>(threads, count);
+
+    std::vector<std::unique_ptr<TaskDeque>> queues;
+    for (int i = 0; i < threads; i++)
+        queues.emplace_back(new TaskDeque());
+    for (size_t i = 0; i < count; i++)
+        queues[i % threads]->Push(order.empty() ? i : order[i]);
+
+    auto run = [&](int worker)
+    {
+        size_t task;
+        for (;;)
+        {
+            bool found = queues[worker]->PopFront(task);
+            for (int k = 1; !found && k < threads; k++)
+                found = queues[(worker + k) % threads]->StealBack(task);
+            // 运行中不会再加入任务,所有队列都空即可退出
+            if (!found)
+                break;
+            fn(worker, task);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; i++)
+        pool.emplace_back(run, i);
+    run(0);
+    for (std::thread &t : pool)
+        t.join();
+    return threads;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// 在 threads 个线程上执行 count 个互相独立的任务 (调用线程也参与,算作其中一个)
+// 任务按 order 的顺序轮流分到每个线程的双端队列: 线程先从自己队列的头部取,
+// 空了再从其他线程队列的尾部偷,避免按块切分时先做完的线程空等
+// fn(worker, task): worker 为 [0, threads) 的线程序号,可用来索引每线程的缓存状态
+// order 为空时按 0..count-1 的顺序分配;threads <= 0 时使用 CPU 核数
+// 返回实际使用的线程数
+int RunWorkStealing(size_t count, int threads, const std::function<void(int worker, size_t task)> &fn,
+                    const std::vector<size_t> &order = std::vector<size_t>());
@@ -0,0 +1,47 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const path = require('path');
+
+// swr 质量档位 (resampleQuality) 对比: 44.1k → 8k/16k/24k 单声道 s16 的吞吐 (倍实时,含解码) 以及相对 'high' 档位的 SNR
+// 用法: node test/bench_resample.js [input] [rounds]
+const inputFile = process.argv[2] || path.join(__dirname, 'test.mp3');
+const rounds = parseInt(process.argv[3] || '5', 10);
+
+function snr(reference, test) {
+    const n = Math.min(reference.length, test.length);
+    let signal = 0;
+    let noise = 0;
+    for (let i = 0; i < n; i++) {
+        signal += reference[i] * reference[i];
+        noise += (reference[i] - test[i]) * (reference[i] - test[i]);
+    }
+    return noise === 0 ? Infinity : 10 * Math.log10(signal / noise);
+}
+
+async function run(sampleRate, resampleQuality) {
+    let best = Infinity;
+    let result;
+    for (let i = 0; i < rounds; i++) {
+        const start = process.hrtime.bigint();
+        result = await addon.decodeAudioToPCM(inputFile, null, { sampleRate, resampleQuality });
+        const elapsed = Number(process.hrtime.bigint() - start) / 1e6;
+        best = Math.min(best, elapsed);
+    }
+    return { elapsed: best, result };
+}
+
+async function benchResample() {
+    const duration = await addon.getDuration(inputFile);
+    console.log(`Input: ${inputFile} (${duration.toFixed(2)} s), ${rounds} rounds (best of)\n`);
+    for (const sampleRate of [8000, 16000, 24000]) {
+        const high = await run(sampleRate, 'high');
+        for (const quality of ['fast', 'default', 'high']) {
+            const preset = quality === 'high' ? high : await run(sampleRate, quality);
+            const speed = duration * 1000 / preset.elapsed;
+            const snrText = quality === 'high' ? '-' : `${snr(high.result.pcm, preset.result.pcm).toFixed(1)} dB`;
+            console.log(`${sampleRate} Hz ${quality.padEnd(7)}: ${preset.elapsed.toFixed(1)} ms (${speed.toFixed(0)}x realtime), ` +
+                `SNR vs high ${snrText}`);
+        }
+    }
+}
+
+benchResample().catch(console.error);
@@ -0,0 +1,38 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const path = require('path');
+const fs = require('fs');
+
+// 用法: node test/bench_silk_profiles.js [input] [rounds]
+const inputFile = process.argv[2] || path.join(__dirname, 'test.mp3');
+const rounds = parseInt(process.argv[3] || '5', 10);
+
+const profiles = {
+    default: {},
+    'nearest': { ratePolicy: 'nearest' },
+    fast: { profile: 'fast' },
+    'fast+40ms': { profile: 'fast', packetSize: 40 },
+    'complexity1': { complexity: 1 },
+    'fec': { fec: true, packetLoss: 10 },
+};
+
+async function benchSilkProfiles() {
+    const duration = await addon.getDuration(inputFile);
+    console.log(`Input: ${inputFile} (${duration.toFixed(2)} s), ${rounds} rounds\n`);
+    console.log('profile'.padEnd(14), 'avg ms'.padStart(10), 'x realtime'.padStart(12), 'bytes'.padStart(10));
+
+    for (const [name, opts] of Object.entries(profiles)) {
+        const outputFile = path.join(__dirname, `bench_${name}.ntsilk`);
+        let total = 0;
+        for (let i = 0; i < rounds; i++) {
+            const start = process.hrtime.bigint();
+            await addon.convertToNTSilkTct(inputFile, outputFile, opts);
+            total += Number(process.hrtime.bigint() - start) / 1e6;
+        }
+        const avg = total / rounds;
+        const size = fs.statSync(outputFile).size;
+        console.log(name.padEnd(14), avg.toFixed(1).padStart(10), (duration * 1000 / avg).toFixed(1).padStart(12), String(size).padStart(10));
+        fs.unlinkSync(outputFile);
+    }
+}
+
+benchSilkProfiles().catch(console.error);
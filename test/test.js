@@ -77,6 +77,12 @@ async function runTests() {
     console.log('转换成功！');
     console.log();
 
+    // 测试 SILK 输入直接改写文件头 (不重新编码)
+    console.log('测试 NTSILK 转 NTSILK (直接复制)...');
+    const silkCopy = await ffmpeg.convertToNTSilkTct(ntsilk_test, path.join(__dirname, 'test_copy.ntsilk'));
+    console.log('是否重新编码:', silkCopy.reencoded);
+    console.log();
+
     // 测试转换后的文件时长
     console.log('测试转换后的 NTSILK 时长...');
     const convertedDuration = await ffmpeg.getDuration(ntsilk_out_test);
@@ -92,11 +98,11 @@ async function runTests() {
       pcmLength: decoded.pcm.length 
     });
 
-    // 验证并写入 WAV
-    if (decoded && Buffer.isBuffer(decoded.pcm)) {
+    // 验证并写入 WAV (pcm 为原生内存上的 Int16Array)
+    if (decoded && decoded.pcm instanceof Int16Array) {
       const bitsPerSample = 16;
       const wavBuffer = createWavBuffer(
-        decoded.pcm, 
+        Buffer.from(decoded.pcm.buffer, decoded.pcm.byteOffset, decoded.pcm.byteLength), 
         decoded.sampleRate || 24000, 
         decoded.channels || 1, 
         bitsPerSample
@@ -105,7 +111,7 @@ async function runTests() {
       fs.writeFileSync(wav_out, wavBuffer);
       console.log('WAV 文件已写入:', wav_out);
     } else {
-      console.error('decodeAudioToPCM 没有返回预期的带有 pcm Buffer 的对象');
+      console.error('decodeAudioToPCM 没有返回预期的带有 pcm Int16Array 的对象');
     }
 
     console.log('\n=== 所有测试完成 ===');
@@ -0,0 +1,51 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const path = require('path');
+
+// 解码会话: 打开一次,多次 seek + read,对比每次重新调用 decodeAudioToPCM 的耗时
+async function testAudioSession() {
+    console.log('Testing openAudio session...\n');
+
+    const inputFile = path.join(__dirname, 'test.mp3');
+    const session = await addon.openAudio(inputFile, { sampleRate: 16000, channels: 1 });
+    console.log(`✓ Opened: ${session.sampleRate} Hz, ${session.channels} ch, ${session.sampleFormat}, ${session.duration.toFixed(2)} s`);
+
+    try {
+        // 顺序读取
+        const first = await session.read(16000);
+        console.log(`✓ read(16000): ${first.samples} samples, position ${first.position.toFixed(3)} s, eof ${first.eof}`);
+
+        // 随机访问: 每次 seek 后读 1 秒
+        const positions = [3, 1, 5, 0.5];
+        const start = Date.now();
+        for (const seconds of positions) {
+            await session.seek(seconds);
+            const chunk = await session.read(16000);
+            console.log(`  seek(${seconds}) -> ${chunk.samples} samples, position ${chunk.position.toFixed(3)} s`);
+        }
+        console.log(`✓ ${positions.length} seek+read in ${Date.now() - start} ms`);
+
+        // 对比: 每次都完整打开并解码一个窗口
+        const baseline = Date.now();
+        for (const seconds of positions) {
+            await addon.decodeAudioToPCM(inputFile, null, { sampleRate: 16000, start: seconds, duration: 1 });
+        }
+        console.log(`  decodeAudioToPCM windows: ${Date.now() - baseline} ms`);
+
+        // 读到结尾
+        await session.seek(Math.max(0, session.duration - 0.5));
+        const tail = await session.read(16000);
+        console.log(`✓ tail read: ${tail.samples} samples, eof ${tail.eof}`);
+    } catch (error) {
+        console.error('✗ Session operation failed:', error.message);
+    }
+
+    await session.close();
+    try {
+        await session.read(100);
+        console.error('✗ read after close should fail');
+    } catch (error) {
+        console.log(`✓ read after close rejected: ${error.message}`);
+    }
+}
+
+testAudioSession().catch(console.error);
@@ -0,0 +1,30 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const fs = require('fs');
+const path = require('path');
+
+async function testConcat() {
+    console.log('Testing concat...\n');
+
+    const inputs = [
+        path.join(__dirname, 'test.ntsilk'),
+        path.join(__dirname, 'test.mp3'),
+        fs.readFileSync(path.join(__dirname, 'test_silk.wav')),
+    ];
+    const cases = [
+        { output: path.join(__dirname, 'concat_out.ntsilk'), format: 'silk', opts: { bitrate: 24000 } },
+        { output: path.join(__dirname, 'concat_out.mp3'), format: 'mp3' },
+    ];
+
+    for (const { output, format, opts } of cases) {
+        try {
+            const start = Date.now();
+            const result = await addon.concat(inputs, output, format, opts);
+            const parts = result.inputs.map((d) => d.toFixed(2)).join(' + ');
+            console.log(`✓ ${format}: ${parts} = ${result.duration.toFixed(2)} s @ ${result.sampleRate} Hz, ${Date.now() - start} ms`);
+        } catch (error) {
+            console.error(`✗ ${format}:`, error.message);
+        }
+    }
+}
+
+testConcat().catch(console.error);
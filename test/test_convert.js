@@ -15,6 +15,42 @@ async function testConvertFile() {
     } catch (error) {
         console.error('✗ MP3 to WAV conversion failed:', error.message);
     }
+
+    // 测试用例 2: MP3 重新封装为 MP3 (直接复制数据包,不转码)
+    try {
+        console.log('Test 2: Remuxing MP3 to MP3 (stream copy)');
+        const inputFile = path.join(__dirname, 'test.mp3');
+        const outputFile = path.join(__dirname, 'test_convert_output.mp3');
+
+        const result = await addon.convertFile(inputFile, outputFile, 'mp3', { mode: 'copy' });
+        console.log('✓ MP3 remux successful:', result);
+    } catch (error) {
+        console.error('✗ MP3 remux failed:', error.message);
+    }
+
+    // 测试用例 3: 从 MP4 中只提取第一条音轨
+    try {
+        console.log('Test 3: Extracting a:0 from MP4 into M4A');
+        const inputFile = path.join(__dirname, 'test.mp4');
+        const outputFile = path.join(__dirname, 'test_convert_output.m4a');
+
+        const result = await addon.convertFile(inputFile, outputFile, 'ipod', { streams: ['a:0'] });
+        console.log('✓ Stream map:', result.streams);
+    } catch (error) {
+        console.error('✗ MP4 audio extraction failed:', error.message);
+    }
+
+    // 测试用例 4: copy 模式下容器不支持输入编码时应报错 (flac 封装只接受 FLAC 音频)
+    try {
+        console.log('Test 4: Forcing stream copy of MP3 into FLAC');
+        const inputFile = path.join(__dirname, 'test.mp3');
+        const outputFile = path.join(__dirname, 'test_convert_copy.flac');
+
+        await addon.convertFile(inputFile, outputFile, 'flac', { mode: 'copy' });
+        console.error('✗ MP3 should not be stream-copied into FLAC');
+    } catch (error) {
+        console.log('✓ Rejected as expected:', error.message);
+    }
 }
 
 // 运行测试
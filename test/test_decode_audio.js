@@ -41,6 +41,46 @@ async function testDecodeAudioToFmt() {
         console.error(`✗ Failed:`, error.message, '\n');
     }
 
+    // Test pipelined mode (decode and encode on separate threads)
+    console.log('Testing pipelined MP3 encoding...');
+    for (const pipeline of [false, true]) {
+        const pipelineOutput = path.join(__dirname, `test_output_pipeline_${pipeline}.mp3`);
+        try {
+            const start = Date.now();
+            await addon.decodeAudioToFmt(inputFile, pipelineOutput, 'mp3', { pipeline });
+            console.log(`✓ pipeline=${pipeline}: ${Date.now() - start} ms`);
+        } catch (error) {
+            console.error(`✗ pipeline=${pipeline} failed:`, error.message);
+        }
+    }
+    console.log();
+
+    // WAV 跳过编码器直接写出,FLAC 经 FIFO 分帧后编码;两者都是无损 s16,解码后应逐采样一致
+    console.log('Comparing WAV bypass output with FIFO-framed FLAC output...');
+    try {
+        const source = path.join(__dirname, 'test.mp3');
+        const wavOutput = path.join(__dirname, 'test_output_bypass.wav');
+        const flacOutput = path.join(__dirname, 'test_output_fifo.flac');
+        const wav = await addon.decodeAudioToFmt(source, wavOutput, 'wav');
+        await addon.decodeAudioToFmt(source, flacOutput, 'flac');
+        const a = (await addon.decodeAudioToPCM(wavOutput, null, wav.sampleRate)).pcm;
+        const b = (await addon.decodeAudioToPCM(flacOutput, null, wav.sampleRate)).pcm;
+        let diff = a.length === b.length ? 0 : -1;
+        for (let i = 0; diff === 0 && i < a.length; i++) {
+            if (a[i] !== b[i])
+                diff = i + 1;
+        }
+        if (diff === 0)
+            console.log(`✓ bypass and FIFO outputs match (${a.length} samples)`);
+        else if (diff < 0)
+            console.error(`✗ sample count differs: bypass ${a.length}, FIFO ${b.length}`);
+        else
+            console.error(`✗ outputs differ at sample ${diff - 1}: bypass ${a[diff - 1]}, FIFO ${b[diff - 1]}`);
+    } catch (error) {
+        console.error('✗ bypass comparison failed:', error.message);
+    }
+    console.log();
+
     console.log('All tests completed!');
 }
 
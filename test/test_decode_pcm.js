@@ -0,0 +1,42 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const path = require('path');
+
+async function testDecodeAudioToPCM() {
+    console.log('Testing decodeAudioToPCM output layouts...\n');
+
+    const inputFile = path.join(__dirname, 'test.mp3');
+    const cases = [
+        { sampleRate: 16000 },
+        { sampleRate: 16000, sampleFormat: 'f32' },
+        { sampleRate: 48000, sampleFormat: 's32', channelLayout: 'stereo' },
+        { sampleRate: 48000, sampleFormat: 'f32', channels: 2, planar: true },
+        // 时间窗口: 期望正好 2 秒 (32000 个采样)
+        { sampleRate: 16000, start: 1, duration: 2 },
+    ];
+
+    for (const opts of cases) {
+        try {
+            const result = await addon.decodeAudioToPCM(inputFile, null, opts);
+            const planes = Array.isArray(result.pcm) ? result.pcm : [result.pcm];
+            console.log(`✓ ${JSON.stringify(opts)}`);
+            console.log(`  - Sample Rate: ${result.sampleRate} Hz`);
+            console.log(`  - Channels: ${result.channels}`);
+            console.log(`  - Format: ${result.sampleFormat}${result.planar ? ' (planar)' : ''}`);
+            console.log(`  - Resampler: ${result.resampler}`);
+            console.log(`  - Planes: ${planes.map(p => `${p.constructor.name}(${p.length})`).join(', ')}\n`);
+        } catch (error) {
+            console.error(`✗ ${JSON.stringify(opts)}:`, error.message, '\n');
+        }
+    }
+
+    // 写文件模式保持兼容: 第三个参数仍可为采样率
+    const outputFile = path.join(__dirname, 'test_output_16k.pcm');
+    try {
+        const result = await addon.decodeAudioToPCM(inputFile, outputFile, 16000);
+        console.log(`✓ File output: ${outputFile} (${result.sampleRate} Hz)`);
+    } catch (error) {
+        console.error('✗ File output failed:', error.message);
+    }
+}
+
+testDecodeAudioToPCM().catch(console.error);
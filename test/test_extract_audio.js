@@ -0,0 +1,45 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const fs = require('fs');
+const path = require('path');
+
+async function testExtractAudio() {
+    console.log('Testing extractAudio function...\n');
+
+    // 测试用例 1: 从 MP4 提取音轨到文件 (按编码自动选择容器)
+    try {
+        console.log('Test 1: Extracting audio from MP4 into M4A');
+        const inputFile = path.join(__dirname, 'test.mp4');
+        const outputFile = path.join(__dirname, 'test_extract_output.m4a');
+
+        const start = Date.now();
+        const result = await addon.extractAudio(inputFile, outputFile);
+        console.log(`✓ Extracted in ${Date.now() - start} ms:`, result);
+    } catch (error) {
+        console.error('✗ MP4 audio extraction failed:', error.message);
+    }
+
+    // 测试用例 2: Buffer 输入,输出到内存
+    try {
+        console.log('Test 2: Extracting audio from an in-memory MP4');
+        const input = fs.readFileSync(path.join(__dirname, 'test.mp4'));
+
+        const result = await addon.extractAudio(input, null);
+        console.log(`✓ ${result.codec} in ${result.format}, ${result.data.length} bytes`);
+    } catch (error) {
+        console.error('✗ Buffer extraction failed:', error.message);
+    }
+
+    // 测试用例 3: 指定不能承载该编码的容器,应当报错
+    try {
+        console.log('Test 3: Forcing MP3 audio into FLAC (should fail)');
+        const inputFile = path.join(__dirname, 'test.mp3');
+        const outputFile = path.join(__dirname, 'test_extract_output.flac');
+
+        await addon.extractAudio(inputFile, outputFile, { format: 'flac' });
+        console.error('✗ Expected an error but extraction succeeded');
+    } catch (error) {
+        console.log('✓ Rejected as expected:', error.message);
+    }
+}
+
+testExtractAudio();
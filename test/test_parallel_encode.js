@@ -0,0 +1,46 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const path = require('path');
+
+// 分段并行编码与串行编码对比: 耗时以及解码后的 SNR
+// wav / flac 都是无损输出,并行结果应与串行逐采样一致 (SNR 为 Infinity)
+// 用法: node test/test_parallel_encode.js [input] [segments]
+// 输入需至少 60 秒 (每段至少 30 秒),且采样率就是输出采样率 (不需要重采样),否则会退回串行
+const inputFile = process.argv[2] || path.join(__dirname, 'test.mp3');
+const segments = Number(process.argv[3] || 4);
+
+function snr(reference, test) {
+    const n = Math.min(reference.length, test.length);
+    let signal = 0;
+    let noise = 0;
+    for (let i = 0; i < n; i++) {
+        signal += reference[i] * reference[i];
+        noise += (reference[i] - test[i]) * (reference[i] - test[i]);
+    }
+    return noise === 0 ? Infinity : 10 * Math.log10(signal / noise);
+}
+
+async function encode(format, parallel) {
+    const outputFile = path.join(__dirname, `test_parallel_${parallel}.${format}`);
+    const start = Date.now();
+    await addon.decodeAudioToFmt(inputFile, outputFile, format, { parallel });
+    const elapsed = Date.now() - start;
+    const decoded = await addon.decodeAudioToPCM(outputFile, null, 24000);
+    return { elapsed, pcm: decoded.pcm };
+}
+
+async function testParallelEncode() {
+    for (const format of ['wav', 'flac']) {
+        try {
+            const serial = await encode(format, 0);
+            const parallel = await encode(format, segments);
+            const value = snr(serial.pcm, parallel.pcm);
+            const mark = value === Infinity && serial.pcm.length === parallel.pcm.length ? '✓' : '✗';
+            console.log(`${mark} ${format}: serial ${serial.elapsed} ms, parallel(${segments}) ${parallel.elapsed} ms, ` +
+                `samples ${serial.pcm.length}/${parallel.pcm.length}, SNR ${value.toFixed(1)} dB`);
+        } catch (error) {
+            console.error(`✗ ${format} failed:`, error.message);
+        }
+    }
+}
+
+testParallelEncode().catch(console.error);
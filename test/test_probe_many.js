@@ -0,0 +1,29 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const path = require('path');
+
+async function testProbeMany() {
+    console.log('Testing probeMany...\n');
+
+    const files = ['test.mp3', 'test.mp4', 'test.ntsilk', 'test_silk.wav', 'missing.mp3'];
+    // 重复多次模拟索引器的批量调用
+    const paths = [];
+    for (let i = 0; i < 200; i++)
+        paths.push(path.join(__dirname, files[i % files.length]));
+
+    for (const opts of [{}, { fast: true }, { concurrency: 1 }]) {
+        const start = Date.now();
+        const result = await addon.probeMany(paths, opts);
+        const failed = result.errors.filter((e) => e !== null).length;
+        console.log(`✓ ${JSON.stringify(opts)}: ${paths.length} files, ${failed} errors, ${Date.now() - start} ms`);
+    }
+
+    const result = await addon.probeMany(files.map((f) => path.join(__dirname, f)));
+    files.forEach((f, i) => {
+        if (result.errors[i])
+            console.log(`  ${f}: ${result.errors[i]}`);
+        else
+            console.log(`  ${f}: ${result.duration[i].toFixed(2)} s, ${result.sampleRate[i]} Hz x ${result.channels[i]}, video=${result.hasVideo[i]}`);
+    });
+}
+
+testProbeMany().catch(console.error);
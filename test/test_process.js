@@ -0,0 +1,37 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const path = require('path');
+
+async function testProcess() {
+    console.log('Testing process (single decode, multiple outputs)...\n');
+
+    const input = path.join(__dirname, 'test.mp3');
+    const outputs = [
+        { type: 'silk', path: path.join(__dirname, 'process_out.ntsilk'), bitrate: 24000 },
+        { type: 'audio', path: path.join(__dirname, 'process_out.amr'), format: 'amr' },
+        { type: 'audio', path: path.join(__dirname, 'process_out.flac'), format: 'flac' },
+        { type: 'duration' },
+        { type: 'waveform', buckets: 100 },
+    ];
+
+    for (const threads of [true, false]) {
+        try {
+            const start = Date.now();
+            const result = await addon.process(input, outputs, { threads });
+            console.log(`✓ threads=${threads}: ${result.duration.toFixed(2)} s @ ${result.sampleRate} Hz, ${Date.now() - start} ms`);
+            for (const out of result.outputs) {
+                if (out.path) {
+                    console.log(`  ${out.success ? '✓' : '✗'} ${out.type} ${path.basename(out.path)}` +
+                        (out.success ? ` @ ${out.sampleRate} Hz` : `: ${out.error}`));
+                } else if (out.type === 'waveform') {
+                    console.log(`  ✓ waveform: ${out.buckets} buckets`);
+                } else {
+                    console.log(`  ✓ duration: ${out.duration.toFixed(2)} s`);
+                }
+            }
+        } catch (error) {
+            console.error(`✗ threads=${threads}:`, error.message);
+        }
+    }
+}
+
+testProcess().catch(console.error);
@@ -0,0 +1,33 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+async function testSegment() {
+    console.log('Testing segment option...\n');
+
+    const input = path.join(__dirname, 'test.mp3');
+    const outDir = fs.mkdtempSync(path.join(os.tmpdir(), 'segment-'));
+    const list = (segments) => segments.map((s) => `${path.basename(s.path || '')}${s.path ? ' ' : ''}${s.duration.toFixed(3)}s`).join(', ');
+
+    try {
+        const silk = await addon.convertToNTSilkTct(input, path.join(outDir, 'voice_%02d.silk'), { segment: 10 });
+        console.log(`✓ convertToNTSilkTct: ${list(silk.segments)}`);
+
+        const mp3 = await addon.decodeAudioToFmt(input, path.join(outDir, 'chunk.mp3'), 'mp3', { segment: 10 });
+        console.log(`✓ decodeAudioToFmt: ${list(mp3.segments)}`);
+
+        const pcmFile = await addon.decodeAudioToPCM(input, path.join(outDir, 'asr.pcm'), { sampleRate: 16000, segment: 30 });
+        console.log(`✓ decodeAudioToPCM (file): ${list(pcmFile.segments)}`);
+
+        const pcm = await addon.decodeAudioToPCM(input, null, { sampleRate: 16000, segment: 30 });
+        const lengths = pcm.segments.map((s) => s.pcm.length);
+        console.log(`✓ decodeAudioToPCM (memory): ${pcm.segments.length} views, lengths ${lengths.join(', ')} of ${pcm.pcm.length}`);
+    } catch (error) {
+        console.error('✗', error.message);
+    }
+
+    fs.rmSync(outDir, { recursive: true, force: true });
+}
+
+testSegment().catch(console.error);
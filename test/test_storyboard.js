@@ -0,0 +1,45 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+async function testStoryboard() {
+    console.log('Testing getStoryboard...\n');
+
+    const input = path.join(__dirname, 'test.mp4');
+    const outDir = fs.mkdtempSync(path.join(os.tmpdir(), 'storyboard-'));
+
+    try {
+        let start = Date.now();
+        const sheet = await addon.getStoryboard(input, { count: 12, width: 160, cols: 4 });
+        const file = path.join(outDir, 'sheet.jpg');
+        fs.writeFileSync(file, sheet.image);
+        console.log(`✓ jpeg ${sheet.width}x${sheet.height} (${sheet.cols}x${sheet.rows} tiles of ${sheet.tileWidth}x${sheet.tileHeight}), ` +
+            `${sheet.image.length} bytes, ${sheet.threads} thread(s), ${Date.now() - start}ms`);
+        console.log(`  timestamps: ${Array.from(sheet.timestamps).map((t) => t.toFixed(2)).join(', ')}`);
+
+        start = Date.now();
+        const png = await addon.getStoryboard(fs.readFileSync(input), { count: 9, width: 120, format: 'png', threads: 3 });
+        console.log(`✓ png from Buffer ${png.width}x${png.height}, ${png.threads} thread(s), ${Date.now() - start}ms`);
+    } catch (error) {
+        console.error('✗', error.message);
+    }
+
+    try {
+        await addon.getStoryboard(input, { count: 0 });
+        console.error('✗ count 0 should be rejected');
+    } catch (error) {
+        console.log(`✓ rejects bad count: ${error.message}`);
+    }
+
+    try {
+        await addon.getStoryboard(input, { count: 1000, width: 2048, cols: 31 });
+        console.error('✗ a sheet over 64 megapixels should be rejected');
+    } catch (error) {
+        console.log(`✓ rejects oversized sheet: ${error.message}`);
+    }
+
+    fs.rmSync(outDir, { recursive: true, force: true });
+}
+
+testStoryboard().catch(console.error);
@@ -0,0 +1,32 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+async function testTranscodeMany() {
+    console.log('Testing transcodeMany...\n');
+
+    const outDir = fs.mkdtempSync(path.join(os.tmpdir(), 'transcode-many-'));
+    const inputs = ['test.mp3', 'test.mp4', 'test.ntsilk', 'test_silk.wav'].map((f) => path.join(__dirname, f));
+    const jobs = [];
+    for (let i = 0; i < 40; i++) {
+        const input = inputs[i % inputs.length];
+        jobs.push(i % 2 === 0
+            ? { input, type: 'silk', path: path.join(outDir, `${i}.ntsilk`), bitrate: 24000 }
+            : { input, type: 'audio', path: path.join(outDir, `${i}.mp3`), format: 'mp3' });
+    }
+
+    for (const concurrency of [1, 0]) {
+        const result = await addon.transcodeMany(jobs, { concurrency });
+        const failed = result.jobs.filter((j) => !j.success);
+        console.log(`✓ concurrency=${concurrency}: ${result.jobs.length} jobs on ${result.threads} threads, ` +
+            `${result.elapsed.toFixed(2)} s, ${result.speed.toFixed(1)}x realtime, ` +
+            `${failed.length} failed`);
+        for (const job of failed)
+            console.log(`  ✗ ${path.basename(job.input)} -> ${path.basename(job.path)}: ${job.error}`);
+    }
+
+    fs.rmSync(outDir, { recursive: true, force: true });
+}
+
+testTranscodeMany().catch(console.error);
@@ -0,0 +1,41 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+async function testTrimSilence() {
+    console.log('Testing trimSilence option...\n');
+
+    const input = path.join(__dirname, 'test.mp3');
+    const outDir = fs.mkdtempSync(path.join(os.tmpdir(), 'trim-'));
+    const show = (t) => `head ${t.head.toFixed(3)}s, tail ${t.tail.toFixed(3)}s`;
+
+    try {
+        const silk = await addon.convertToNTSilkTct(input, path.join(outDir, 'voice.silk'), { trimSilence: true });
+        console.log(`✓ convertToNTSilkTct: ${show(silk.trimmed)}`);
+
+        const mp3 = await addon.decodeAudioToFmt(input, path.join(outDir, 'trimmed.mp3'), 'mp3', {
+            trimSilence: { threshold: -40, minDuration: 0.2 },
+        });
+        console.log(`✓ decodeAudioToFmt: ${show(mp3.trimmed)}`);
+
+        const res = await addon.process(input, [
+            { type: 'silk', path: path.join(outDir, 'process.silk'), trimSilence: true },
+            { type: 'audio', path: path.join(outDir, 'process.wav'), format: 'wav' },
+        ]);
+        console.log(`✓ process: ${show(res.outputs[0].trimmed)}, untrimmed output has trimmed=${res.outputs[1].trimmed}`);
+    } catch (error) {
+        console.error('✗', error.message);
+    }
+
+    try {
+        await addon.decodeAudioToFmt(input, path.join(outDir, 'bad.mp3'), 'mp3', { trimSilence: { threshold: 6 } });
+        console.error('✗ positive threshold should be rejected');
+    } catch (error) {
+        console.log(`✓ rejects bad threshold: ${error.message}`);
+    }
+
+    fs.rmSync(outDir, { recursive: true, force: true });
+}
+
+testTrimSilence().catch(console.error);
@@ -0,0 +1,28 @@
+const addon = require('../build/Release/ffmpegAddon.node');
+const fs = require('fs');
+const path = require('path');
+
+async function testGetWaveform() {
+    console.log('Testing getWaveform...\n');
+
+    const cases = [
+        { input: path.join(__dirname, 'test.mp3'), opts: { buckets: 200 } },
+        { input: path.join(__dirname, 'test.ntsilk'), opts: { buckets: 100, sampleFormat: 's16' } },
+        { input: fs.readFileSync(path.join(__dirname, 'test.mp3')), opts: { buckets: 50 }, label: 'Buffer' },
+    ];
+
+    for (const { input, opts, label } of cases) {
+        const name = label || path.basename(input);
+        try {
+            const start = Date.now();
+            const result = await addon.getWaveform(input, opts);
+            const peak = Math.max(...Array.from(result.max));
+            console.log(`✓ ${name}: ${result.buckets} buckets (${result.max.constructor.name}), ` +
+                `${result.duration.toFixed(2)} s @ ${result.sampleRate} Hz, peak ${peak}, ${Date.now() - start} ms`);
+        } catch (error) {
+            console.error(`✗ ${name}:`, error.message);
+        }
+    }
+}
+
+testGetWaveform().catch(console.error);